@@ -14,13 +14,6 @@
 #include "dialogs/settingsdialog.hpp"
 #include "dialogs/certificateselectiondialog.hpp"
 
-#include "protocols/geminiclient.hpp"
-#include "protocols/webclient.hpp"
-#include "protocols/gopherclient.hpp"
-#include "protocols/fingerclient.hpp"
-#include "protocols/abouthandler.hpp"
-#include "protocols/filehandler.hpp"
-
 #include "ioutil.hpp"
 #include "kristall.hpp"
 #include "widgets/favouritepopup.hpp"
@@ -53,12 +46,17 @@
 #include <QGraphicsPixmapItem>
 #include <QGraphicsTextItem>
 #include <QRegularExpression>
+#include <QTextBlock>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSet>
+#include <QLocale>
 #include <iconv.h>
+#include <cmath>
 
 BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
                                                  ui(new Ui::BrowserTab),
                                                  mainWindow(mainWindow),
-                                                 current_handler(nullptr),
                                                  outline(),
                                                  graphics_scene()
 {
@@ -66,16 +64,10 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
     this->setUiDensity(kristall::globals().options.ui_density);
 
-    addProtocolHandler<GeminiClient>();
-    addProtocolHandler<FingerClient>();
-    addProtocolHandler<GopherClient>();
-    addProtocolHandler<WebClient>();
-    addProtocolHandler<AboutHandler>();
-    addProtocolHandler<FileHandler>();
-
     this->updateUI();
 
     this->ui->search_bar->setVisible(false);
+    this->ui->cache_banner->setVisible(false);
 
     this->ui->media_browser->setVisible(false);
     this->ui->graphics_browser->setVisible(false);
@@ -98,10 +90,33 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
     connect(this->ui->url_bar, &SearchBar::escapePressed, this, &BrowserTab::on_url_bar_escapePressed);
 
-    this->network_timeout_timer.setSingleShot(true);
-    this->network_timeout_timer.setTimerType(Qt::PreciseTimer);
+    // Handlers report progress for each received chunk, which can happen
+    // thousands of times per second. The UI is updated about once per frame.
+    this->progress_timer.setSingleShot(true);
+    this->progress_timer.setInterval(16);
+
+    connect(&this->progress_timer, &QTimer::timeout, this, &BrowserTab::on_progressTimeout);
+
+    // Streamed responses are not rendered for each chunk, but
+    // in small intervals to keep the UI responsive.
+    this->stream_render_timer.setSingleShot(true);
+    this->stream_render_timer.setInterval(100);
+
+    connect(&this->stream_render_timer, &QTimer::timeout, this, &BrowserTab::on_streamRenderTimeout);
+
+    // Links are only prefetched when the mouse rests on them for a moment,
+    // not when it just passes over them.
+    this->prefetch_timer.setSingleShot(true);
+    this->prefetch_timer.setInterval(400);
 
-    connect(&this->network_timeout_timer, &QTimer::timeout, this, &BrowserTab::on_networkTimeout);
+    connect(&this->prefetch_timer, &QTimer::timeout, this, &BrowserTab::on_prefetchTimeout);
+
+    // Typing into the url bar only connects once the host name
+    // is likely complete, not for every partial name.
+    this->preconnect_timer.setSingleShot(true);
+    this->preconnect_timer.setInterval(300);
+
+    connect(&this->preconnect_timer, &QTimer::timeout, this, &BrowserTab::on_preconnectTimeout);
 
 
 
@@ -168,6 +183,12 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
 BrowserTab::~BrowserTab()
 {
+    // Requests are owned by the network service and would outlive the tab
+    if (this->isRequestInProgress())
+        this->current_request->cancel();
+    this->cancelPrefetch();
+    this->cancelRevalidation();
+
     delete ui;
 }
 
@@ -179,11 +200,7 @@ void BrowserTab::navigateTo(const QUrl &url, PushToHistory mode, RequestFlags fl
         return;
     }
 
-    if ((this->current_handler != nullptr) and not this->current_handler->cancelRequest())
-    {
-        QMessageBox::warning(this, tr("Kristall"), tr("Failed to cancel running request!"));
-        return;
-    }
+    this->cancelRequest();
 
     // If this page is in cache, store the scroll position
     if (auto pg = kristall::globals().cache.find(this->current_location); pg != nullptr)
@@ -200,8 +217,9 @@ void BrowserTab::navigateTo(const QUrl &url, PushToHistory mode, RequestFlags fl
         return;
     }
 
+    // The request may go to a remembered redirection target
     if(mode == PushImmediate) {
-        pushToHistory(url);
+        pushToHistory(this->current_location);
     }
 
     this->updateUI();
@@ -315,6 +333,49 @@ void BrowserTab::openSourceView()
     dialog->exec();
 }
 
+void BrowserTab::openTimingView()
+{
+    QFont monospace_font("monospace");
+    monospace_font.setStyleHint(QFont::Monospace);
+
+    auto dialog = std::make_unique<QDialog>(this, Qt::WindowTitleHint | Qt::WindowSystemMenuHint);
+    dialog->setWindowTitle(QString(tr("Timings of %0")).arg(this->current_location.toString()));
+
+    auto layout = new QVBoxLayout(dialog.get());
+    dialog->setLayout(layout);
+
+    auto const & stats = this->current_stats;
+
+    QString details;
+    if(stats.loaded_from_cache) {
+        details = tr("The document was loaded from the cache.");
+    } else if(stats.timings.isValid()) {
+        details = stats.timings.toString();
+    } else {
+        details = tr("No network timings were recorded for this document.");
+    }
+    details += "\n\n";
+    details += QString(tr("Loading time: %1 ms\nRendering time: %2 ms")).arg(stats.loading_time).arg(stats.render_time);
+    if(stats.throughput > 0)
+        details += QString(tr("\nThroughput: %1/s")).arg(IoUtil::size_human(stats.throughput));
+
+    auto text = new QPlainTextEdit(dialog.get());
+    text->setPlainText(details);
+    text->setReadOnly(true);
+    text->setFont(monospace_font);
+    text->setWordWrapMode(QTextOption::NoWrap);
+    layout->addWidget(text);
+
+    auto buttons = new QDialogButtonBox(dialog.get());
+    buttons->setStandardButtons(QDialogButtonBox::Ok);
+    layout->addWidget(buttons);
+
+    connect(buttons->button(QDialogButtonBox::Ok), &QPushButton::pressed, dialog.get(), &QDialog::accept);
+
+    dialog->resize(480, 320);
+    dialog->exec();
+}
+
 void BrowserTab::on_url_bar_returnPressed()
 {
     QString urltext = this->ui->url_bar->text().trimmed();
@@ -366,6 +427,27 @@ void BrowserTab::on_url_bar_escapePressed()
     this->setUrlBarText(this->current_location.toString(QUrl::FullyEncoded));
 }
 
+void BrowserTab::on_url_bar_textEdited(const QString &text)
+{
+    Q_UNUSED(text)
+    if (kristall::globals().options.enable_preconnect)
+        this->preconnect_timer.start();
+}
+
+void BrowserTab::on_preconnectTimeout()
+{
+    QString const urltext = this->ui->url_bar->text().trimmed();
+
+    // Same rule as on_url_bar_returnPressed: text without a scheme,
+    // but with a top-level domain, is a gemini address.
+    QUrl url { urltext };
+    if (url.scheme().isEmpty())
+        url = QUrl { "gemini://" + urltext };
+
+    if (url.isValid() and url.host().contains("."))
+        kristall::globals().connections.preconnect(url);
+}
+
 void BrowserTab::on_url_bar_focused()
 {
     this->updateUrlBarStyle();
@@ -393,7 +475,8 @@ void BrowserTab::on_parent_button_clicked()
 
 void BrowserTab::on_networkError(ProtocolHandler::NetworkError error_code, const QString &reason)
 {
-    this->network_timeout_timer.stop();
+    if (this->showCachedFallback(error_code, reason))
+        return;
 
     QString file_name;
     switch(error_code)
@@ -412,6 +495,14 @@ void BrowserTab::on_networkError(ProtocolHandler::NetworkError error_code, const
     case ProtocolHandler::Unauthorized: file_name = "Unauthorized.gemini"; break;
     case ProtocolHandler::TlsFailure: file_name = "TlsFailure.gemini"; break;
     case ProtocolHandler::Timeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::DownloadLimitExceeded: file_name = "DownloadLimitExceeded.gemini"; break;
+    case ProtocolHandler::HostLookupTimeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::ConnectTimeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::TlsHandshakeTimeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::ResponseTimeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::TransferTimeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::SlowDown: file_name = "SlowDown.gemini"; break;
+    case ProtocolHandler::Offline: file_name = "Offline.gemini"; break;
     }
     file_name = ":/error_page/" + file_name;
 
@@ -432,14 +523,6 @@ void BrowserTab::on_networkError(ProtocolHandler::NetworkError error_code, const
     this->updateUI();
 }
 
-void BrowserTab::on_networkTimeout()
-{
-    if(this->current_handler != nullptr) {
-        this->current_handler->cancelRequest();
-    }
-    on_networkError(ProtocolHandler::Timeout, tr("The server didn't respond in time."));
-}
-
 void BrowserTab::on_focusSearchbar()
 {
     this->focusSearchBar();
@@ -447,8 +530,6 @@ void BrowserTab::on_focusSearchbar()
 
 void BrowserTab::on_certificateRequired(const QString &reason)
 {
-    this->network_timeout_timer.stop();
-
     if (not trySetClientCertificate(reason))
     {
         setErrorMessage(QString(tr("The page requested a authorized client certificate, but none was provided.\r\nOriginal query was: %1")).arg(reason));
@@ -465,6 +546,14 @@ void BrowserTab::on_hostCertificateLoaded(const QSslCertificate &cert)
     this->current_server_certificate = cert;
 }
 
+//! Returns the average transfer rate of a finished document in bytes per second
+static qint64 averageThroughput(DocumentStats const & stats)
+{
+    if (stats.loaded_from_cache or stats.loading_time <= 0)
+        return 0;
+    return 1000 * stats.file_size / stats.loading_time;
+}
+
 static QByteArray convertToUtf8(QByteArray const & input, QString const & charSet)
 {
     auto charset_u8 = charSet.toUpper().toUtf8();
@@ -541,7 +630,19 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
     QByteArray data;
 
     this->ui->media_browser->stopPlaying();
-    this->network_timeout_timer.stop();
+
+    // Keep the scroll position if the user already started
+    // reading the streamed preview of this document.
+    int preview_scroll = -1;
+    if(this->stream_preview_shown and not this->is_internal_location) {
+        preview_scroll = this->ui->text_browser->verticalScrollBar()->value();
+    }
+
+    // A streamed document is completed by renderPage, everything
+    // else replaces the preview.
+    if(this->is_internal_location) {
+        this->resetStreamPreview();
+    }
 
     qDebug() << "Loaded" << ref_data.length() << "bytes of type" << mime.type << "/" << mime.subtype;
 //    for(auto & key : mime.parameters.keys()) {
@@ -576,16 +677,36 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
     this->successfully_loaded = true;
     this->page_title = "";
 
+    QElapsedTimer render_timer;
+    render_timer.start();
+
     renderPage(data, mime);
 
+    int const render_time = int(render_timer.elapsed());
+
+    if(preview_scroll >= 0) {
+        this->ui->text_browser->verticalScrollBar()->setValue(preview_scroll);
+    }
+
     this->updatePageTitle();
 
     this->updateUrlBarStyle();
 
+    this->progress_timer.stop();
+
     this->current_stats.file_size = ref_data.size();
     this->current_stats.mime_type = mime;
     this->current_stats.loading_time = this->timer.elapsed();
     this->current_stats.loaded_from_cache = was_read_from_cache;
+    this->current_stats.is_in_progress = false;
+    this->current_stats.expected_size = -1;
+    this->current_stats.eta = -1;
+    this->current_stats.throughput = averageThroughput(this->current_stats);
+    this->current_stats.render_time = render_time;
+    if(this->current_request != nullptr and not was_read_from_cache and not this->is_internal_location)
+        this->current_stats.timings = this->current_request->timings();
+    else
+        this->current_stats.timings = RequestTimings { };
     emit this->fileLoaded(this->current_stats);
 
     this->updateMouseCursor(false);
@@ -594,13 +715,92 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
     this->request_state = RequestState::None;
 }
 
+void BrowserTab::on_requestCompleteFile(const QString &file_name, const QString &mime_text)
+{
+    this->resetStreamPreview();
+    this->updateMouseCursor(false);
+
+    auto mime = MimeParser::parse(mime_text);
+    qint64 const file_size = QFileInfo(file_name).size();
+
+    qDebug() << "Downloaded" << file_size << "bytes of type" << mime.type << "/" << mime.subtype << "into" << file_name;
+
+    // The document is too large to be displayed, so we offer to save it instead
+    QFileDialog dialog { this };
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setWindowTitle(tr("Save large document (%1)").arg(IoUtil::size_human(file_size)));
+    dialog.selectFile(this->current_location.fileName());
+
+    QString saved_file;
+    if (dialog.exec() == QFileDialog::Accepted)
+    {
+        QString target = dialog.selectedFiles().at(0);
+
+        // The dialog already asked for overwriting
+        QFile::remove(target);
+        if (QFile::copy(file_name, target)) {
+            saved_file = target;
+        } else {
+            QMessageBox::warning(this, tr("Kristall"), tr("Could not save file:\r\n%1").arg(target));
+        }
+    }
+
+    QString page = tr(
+        "# Large Document\n"
+        "\n"
+        "The requested document is too large to be displayed.\n"
+        "\n"
+        "```\n"
+        "Details:\n"
+        "- MIME type: %1/%2\n"
+        "- Size: %3\n"
+        "```\n"
+    ).arg(mime.type, mime.subtype, IoUtil::size_human(file_size));
+
+    if (saved_file.isEmpty())
+        page += tr("\nThe document was not saved.\n");
+    else
+        page += tr("\nThe document was saved to:\n=> file://%1\n").arg(QUrl::toPercentEncoding(saved_file, "/").constData());
+
+    this->is_internal_location = true;
+    this->on_requestComplete(page.toUtf8(), "text/gemini");
+
+    this->current_stats.file_size = file_size;
+    this->current_stats.mime_type = mime;
+    this->current_stats.throughput = averageThroughput(this->current_stats);
+    if(this->current_request != nullptr)
+        this->current_stats.timings = this->current_request->timings();
+    emit this->fileLoaded(this->current_stats);
+
+    this->updateUI();
+}
+
 void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
 {
     this->current_mime = mime;
     this->current_buffer = data;
 
+    bool plaintext_only = (kristall::globals().options.text_display == GenericSettings::PlainText);
+
+    // If the document was streamed in, the incremental renderer already
+    // contains most of it and only the remaining input has to be rendered.
+    std::unique_ptr<IncrementalGeminiRenderer> stream_renderer = std::move(this->stream_renderer);
+    std::unique_ptr<IncrementalGophermapRenderer> stream_gophermap_renderer = std::move(this->stream_gophermap_renderer);
+    this->resetStreamPreview();
+
+    bool const use_stream_renderer = (stream_renderer != nullptr)
+        and not plaintext_only
+        and mime.is("text", "gemini")
+        and (stream_renderer->inputSize() <= data.size());
+
+    bool const use_stream_gophermap_renderer = (stream_gophermap_renderer != nullptr)
+        and not plaintext_only
+        and mime.is("text", "gophermap")
+        and (stream_gophermap_renderer->inputSize() <= data.size());
+
     this->graphics_scene.clear();
-    this->ui->text_browser->setText("");
+    if (not use_stream_renderer and not use_stream_gophermap_renderer)
+        this->ui->text_browser->setText("");
 
     ui->text_browser->setStyleSheet("");
 
@@ -620,12 +820,27 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
 
     this->ui->text_browser->setStyleSheet(QString("QTextBrowser { background-color: %1; color: %2; }").arg(doc_style.background_color.name(), doc_style.standard_color.name()));
 
-    bool plaintext_only = (kristall::globals().options.text_display == GenericSettings::PlainText);
-
     // Only cache text pages
     bool will_cache = true;
 
-    if (not plaintext_only and mime.is("text", "gemini"))
+    if (use_stream_renderer)
+    {
+        stream_renderer->append(data.mid(int(stream_renderer->inputSize())));
+        stream_renderer->finish();
+
+        if (this->page_title.isEmpty())
+            this->page_title = stream_renderer->pageTitle();
+
+        document = stream_renderer->takeDocument();
+    }
+    else if (use_stream_gophermap_renderer)
+    {
+        stream_gophermap_renderer->append(data.mid(int(stream_gophermap_renderer->inputSize())));
+        stream_gophermap_renderer->finish();
+
+        document = stream_gophermap_renderer->takeDocument();
+    }
+    else if (not plaintext_only and mime.is("text", "gemini"))
     {
         document = GeminiRenderer::render(
             data,
@@ -795,6 +1010,8 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
     this->current_style = std::move(doc_style);
     this->updatePageMargins();
 
+    this->prefetchLinkedHosts();
+
     this->needs_rerender = false;
 
     emit this->locationChanged(this->current_location);
@@ -853,8 +1070,6 @@ void BrowserTab::updatePageTitle()
 
 void BrowserTab::on_inputRequired(const QString &query, const bool is_sensitive)
 {
-    this->network_timeout_timer.stop();
-
     QInputDialog dialog{this};
 
     dialog.setInputMode(QInputDialog::TextInput);
@@ -888,10 +1103,6 @@ void BrowserTab::on_inputRequired(const QString &query, const bool is_sensitive)
 
 void BrowserTab::on_redirected(QUrl uri, bool is_permanent)
 {
-    Q_UNUSED(is_permanent);
-
-    this->network_timeout_timer.stop();
-
     // #79: Handle non-full url redirects
     if (uri.isRelative())
     {
@@ -907,55 +1118,19 @@ void BrowserTab::on_redirected(QUrl uri, bool is_permanent)
     }
     else
     {
-        bool is_cross_protocol = (this->current_location.scheme() != uri.scheme());
-        bool is_cross_host = (this->current_location.host() != uri.host());
-
-        QString question;
-        if(kristall::globals().options.redirection_policy == GenericSettings::WarnAlways)
-        {
-            question = QString(
-                tr("The location you visited wants to redirect you to another location:\r\n"
-                "%1\r\n"
-                "Do you want to allow the redirection?")
-            ).arg(uri.toString(QUrl::FullyEncoded));
-        }
-        else if((kristall::globals().options.redirection_policy & (GenericSettings::WarnOnHostChange | GenericSettings::WarnOnSchemeChange)) and is_cross_protocol and is_cross_host)
-        {
-            question = QString(
-                tr("The location you visited wants to redirect you to another host and switch the protocol.\r\n"
-                "Protocol: %1\r\n"
-                "New Host: %2\r\n"
-                "Do you want to allow the redirection?")
-            ).arg(uri.scheme()).arg(uri.host());
-        }
-        else if((kristall::globals().options.redirection_policy & GenericSettings::WarnOnSchemeChange) and is_cross_protocol)
+        if (not this->confirmRedirection(this->current_location, uri))
         {
-            question = QString(
-                tr("The location you visited wants to switch the protocol.\r\n"
-                "Protocol: %1\r\n"
-                "Do you want to allow the redirection?")
-            ).arg(uri.scheme());
-        }
-        else if((kristall::globals().options.redirection_policy & GenericSettings::WarnOnHostChange) and is_cross_host)
-        {
-            question = QString(
-                tr("The location you visited wants to redirect you to another host.\r\n"
-                "New Host: %1\r\n"
-                "Do you want to allow the redirection?")
-            ).arg(uri.host());
+            setErrorMessage(QString(tr("Redirection to %1 cancelled by user")).arg(uri.toString()));
+            return;
         }
 
-        if (!question.isEmpty())
+        // Remember permanent redirections, so the next visit skips the
+        // old location. Identities may see different redirections, so
+        // only anonymous ones are stored. Redirections the policy asks
+        // about are not stored, as following them would ask again.
+        if (is_permanent and not this->current_identity.isValid() and this->redirectionQuestion(this->current_location, uri).isEmpty())
         {
-            auto answer = QMessageBox::question(
-                this,
-                tr("Kristall"),
-                question
-            );
-            if(answer != QMessageBox::Yes) {
-                setErrorMessage(QString(tr("Redirection to %1 cancelled by user")).arg(uri.toString()));
-                return;
-            }
+            kristall::globals().redirects.store(this->current_location, uri);
         }
 
         if (this->startRequest(uri, ProtocolHandler::Default))
@@ -972,6 +1147,63 @@ void BrowserTab::on_redirected(QUrl uri, bool is_permanent)
     }
 }
 
+bool BrowserTab::confirmRedirection(const QUrl &from, const QUrl &to)
+{
+    QString const question = this->redirectionQuestion(from, to);
+    if (question.isEmpty())
+        return true;
+
+    auto answer = QMessageBox::question(
+        this,
+        tr("Kristall"),
+        question
+    );
+    return (answer == QMessageBox::Yes);
+}
+
+QString BrowserTab::redirectionQuestion(const QUrl &from, const QUrl &to) const
+{
+    bool is_cross_protocol = (from.scheme() != to.scheme());
+    bool is_cross_host = (from.host() != to.host());
+
+    QString question;
+    if(kristall::globals().options.redirection_policy == GenericSettings::WarnAlways)
+    {
+        question = QString(
+            tr("The location you visited wants to redirect you to another location:\r\n"
+            "%1\r\n"
+            "Do you want to allow the redirection?")
+        ).arg(to.toString(QUrl::FullyEncoded));
+    }
+    else if((kristall::globals().options.redirection_policy & (GenericSettings::WarnOnHostChange | GenericSettings::WarnOnSchemeChange)) and is_cross_protocol and is_cross_host)
+    {
+        question = QString(
+            tr("The location you visited wants to redirect you to another host and switch the protocol.\r\n"
+            "Protocol: %1\r\n"
+            "New Host: %2\r\n"
+            "Do you want to allow the redirection?")
+        ).arg(to.scheme()).arg(to.host());
+    }
+    else if((kristall::globals().options.redirection_policy & GenericSettings::WarnOnSchemeChange) and is_cross_protocol)
+    {
+        question = QString(
+            tr("The location you visited wants to switch the protocol.\r\n"
+            "Protocol: %1\r\n"
+            "Do you want to allow the redirection?")
+        ).arg(to.scheme());
+    }
+    else if((kristall::globals().options.redirection_policy & GenericSettings::WarnOnHostChange) and is_cross_host)
+    {
+        question = QString(
+            tr("The location you visited wants to redirect you to another host.\r\n"
+            "New Host: %1\r\n"
+            "Do you want to allow the redirection?")
+        ).arg(to.host());
+    }
+
+    return question;
+}
+
 void BrowserTab::setErrorMessage(const QString &msg)
 {
     this->is_internal_location = true;
@@ -1222,18 +1454,20 @@ void BrowserTab::on_text_browser_highlighted(const QUrl &url)
         if (real_url.isRelative())
             real_url = this->current_location.resolved(url);
         this->mainWindow->setUrlPreview(real_url);
+        this->schedulePrefetch(real_url);
+        if (real_url.host() != this->current_location.host())
+            kristall::globals().connections.preconnect(real_url);
     }
     else
     {
         this->mainWindow->setUrlPreview(QUrl{});
+        this->schedulePrefetch(QUrl{});
     }
 }
 
 void BrowserTab::on_stop_button_clicked()
 {
-    if(this->current_handler != nullptr) {
-        this->current_handler->cancelRequest();
-    }
+    this->cancelRequest();
     this->updateUI();
 }
 
@@ -1242,16 +1476,377 @@ void BrowserTab::on_home_button_clicked()
     this->navigateTo(QUrl(kristall::globals().options.start_page), BrowserTab::PushImmediate);
 }
 
-void BrowserTab::on_requestProgress(qint64 transferred)
+void BrowserTab::on_requestProgress(qint64 transferred, qint64 total)
+{
+    this->progress_transferred = transferred;
+    this->progress_total = total;
+
+    if (not this->progress_timer.isActive())
+        this->progress_timer.start();
+}
+
+void BrowserTab::on_progressTimeout()
 {
-    this->current_stats.file_size = transferred;
+    // The request may have finished since the last report
+    if (not this->isRequestInProgress())
+        return;
+
+    qint64 const now = this->timer.elapsed();
+    qint64 const elapsed = now - this->throughput_sample_time;
+    if (elapsed > 0)
+    {
+        double const rate = 1000.0 * double(this->progress_transferred - this->throughput_sample_size) / double(elapsed);
+
+        // Exponential moving average with a time constant of one second
+        double const weight = 1.0 - std::exp(-double(elapsed) / 1000.0);
+        if (this->throughput <= 0.0)
+            this->throughput = rate;
+        else
+            this->throughput += weight * (rate - this->throughput);
+
+        this->throughput_sample_size = this->progress_transferred;
+        this->throughput_sample_time = now;
+    }
+
+    this->current_stats.file_size = this->progress_transferred;
     this->current_stats.mime_type = MimeType { };
-    this->current_stats.loading_time = this->timer.elapsed();
+    this->current_stats.loading_time = int(now);
     this->current_stats.loaded_from_cache = false;
+    this->current_stats.is_in_progress = true;
+    this->current_stats.expected_size = this->progress_total;
+    this->current_stats.throughput = qint64(this->throughput);
+    if (this->progress_total > this->progress_transferred and this->throughput > 0.0)
+        this->current_stats.eta = int(1000.0 * double(this->progress_total - this->progress_transferred) / this->throughput);
+    else
+        this->current_stats.eta = -1;
     emit this->fileLoaded(this->current_stats);
+}
+
+void BrowserTab::on_responseStarted(const QString &mime_text)
+{
+    auto mime = MimeParser::parse(mime_text);
+
+    this->resetStreamPreview();
+
+    // Only documents that can be rendered line by line are previewed.
+    // Everything else is displayed when the request is complete.
+    auto charset = mime.parameter("charset", "utf-8").toUpper();
+    this->is_streaming = mime.is("text")
+        and (charset == "UTF-8")
+        and not mime.is("text", "html")
+        and not mime.is("text", "markdown")
+        and not mime.is("text", "x-kristall-theme");
+
+    // Gemtext and gopher menus are rendered incrementally, so each
+    // chunk only costs the time to lay out the new lines.
+    bool plaintext_only = (kristall::globals().options.text_display == GenericSettings::PlainText);
+    if(this->is_streaming and not plaintext_only and mime.is("text", "gemini"))
+    {
+        this->stream_renderer = std::make_unique<IncrementalGeminiRenderer>(
+            this->current_location,
+            kristall::globals().document_style.derive(this->current_location),
+            this->outline);
+    }
+    else if(this->is_streaming and not plaintext_only and mime.is("text", "gophermap"))
+    {
+        this->stream_gophermap_renderer = std::make_unique<IncrementalGophermapRenderer>(
+            this->current_location,
+            kristall::globals().document_style.derive(this->current_location));
+    }
+    else if(this->is_streaming)
+    {
+        this->stream_plaintext_renderer = std::make_unique<IncrementalPlainTextRenderer>(
+            kristall::globals().document_style.derive(this->current_location));
+    }
+}
+
+void BrowserTab::on_responseData(const QByteArray &chunk)
+{
+    if(not this->is_streaming)
+        return;
+
+    this->stream_buffer.append(chunk);
+
+    if(not this->stream_render_timer.isActive()) {
+        this->stream_render_timer.start();
+    }
+}
+
+void BrowserTab::on_streamRenderTimeout()
+{
+    this->renderStreamPreview();
+}
+
+void BrowserTab::renderStreamPreview()
+{
+    if(not this->is_streaming)
+        return;
+
+    if(this->stream_renderer != nullptr)
+    {
+        auto scroll = this->ui->text_browser->verticalScrollBar()->value();
+
+        this->stream_renderer->append(this->stream_buffer.mid(int(this->stream_renderer->inputSize())));
+        this->showStreamDocument(this->stream_renderer->document());
+
+        this->ui->text_browser->verticalScrollBar()->setValue(scroll);
+
+        auto const & title = this->stream_renderer->pageTitle();
+        if (not title.isEmpty() and title != this->page_title)
+        {
+            this->page_title = title;
+            this->updatePageTitle();
+        }
+        return;
+    }
+
+    if(this->stream_gophermap_renderer != nullptr)
+    {
+        auto scroll = this->ui->text_browser->verticalScrollBar()->value();
+
+        this->stream_gophermap_renderer->append(this->stream_buffer.mid(int(this->stream_gophermap_renderer->inputSize())));
+        this->showStreamDocument(this->stream_gophermap_renderer->document());
+
+        this->ui->text_browser->verticalScrollBar()->setValue(scroll);
+        return;
+    }
+
+    if(this->stream_plaintext_renderer != nullptr)
+    {
+        auto scroll = this->ui->text_browser->verticalScrollBar()->value();
+
+        this->stream_plaintext_renderer->append(this->stream_buffer.mid(int(this->stream_plaintext_renderer->inputSize())));
+        this->showStreamDocument(this->stream_plaintext_renderer->document());
+
+        this->ui->text_browser->verticalScrollBar()->setValue(scroll);
+    }
+}
 
-    this->network_timeout_timer.stop();
-    this->network_timeout_timer.start(kristall::globals().options.network_timeout);
+void BrowserTab::showStreamDocument(QTextDocument *document)
+{
+    if (this->stream_preview_shown)
+        return;
+
+    auto doc_style = kristall::globals().document_style.derive(this->current_location);
+
+    this->graphics_scene.clear();
+    this->ui->text_browser->setStyleSheet(QString("QTextBrowser { background-color: %1; color: %2; }").arg(doc_style.background_color.name(), doc_style.standard_color.name()));
+    this->ui->text_browser->setVisible(true);
+    this->ui->graphics_browser->setVisible(false);
+    this->ui->media_browser->setVisible(false);
+
+    this->ui->text_browser->setDocument(document);
+    this->current_style = std::move(doc_style);
+    this->stream_preview_shown = true;
+    this->updatePageMargins();
+}
+
+void BrowserTab::resetStreamPreview()
+{
+    if(this->stream_renderer != nullptr)
+    {
+        // The text browser still displays the partially rendered
+        // document, so we must keep it alive.
+        if(this->stream_preview_shown) {
+            this->current_document = this->stream_renderer->takeDocument();
+        }
+        this->stream_renderer.reset();
+    }
+    if(this->stream_gophermap_renderer != nullptr)
+    {
+        if(this->stream_preview_shown) {
+            this->current_document = this->stream_gophermap_renderer->takeDocument();
+        }
+        this->stream_gophermap_renderer.reset();
+    }
+    if(this->stream_plaintext_renderer != nullptr)
+    {
+        if(this->stream_preview_shown) {
+            this->current_document = this->stream_plaintext_renderer->takeDocument();
+        }
+        this->stream_plaintext_renderer.reset();
+    }
+
+    this->stream_render_timer.stop();
+    this->stream_buffer.clear();
+    this->is_streaming = false;
+    this->stream_preview_shown = false;
+}
+
+void BrowserTab::prefetchLinkedHosts()
+{
+    if (this->current_document == nullptr)
+        return;
+
+    QSet<QString> hosts;
+    hosts.insert(this->current_location.host());
+
+    for (QTextBlock block = this->current_document->begin(); block.isValid(); block = block.next())
+    {
+        for (auto it = block.begin(); not it.atEnd(); ++it)
+        {
+            QTextFragment const fragment = it.fragment();
+            if (not fragment.isValid() or not fragment.charFormat().isAnchor())
+                continue;
+
+            QUrl const url = this->current_location.resolved(QUrl(fragment.charFormat().anchorHref()));
+            if (url.host().isEmpty() or hosts.contains(url.host()))
+                continue;
+
+            QString const scheme = url.scheme();
+            if (scheme != "gemini" and scheme != "gopher" and scheme != "finger")
+                continue;
+
+            hosts.insert(url.host());
+            kristall::globals().resolver.prefetch(url.host());
+
+            if (hosts.size() > HostResolver::max_prefetch_count)
+                return;
+        }
+    }
+}
+
+void BrowserTab::schedulePrefetch(const QUrl &url)
+{
+    QUrl const target = url.adjusted(QUrl::RemoveFragment);
+    if (target == this->prefetch_url)
+        return;
+
+    this->cancelPrefetch();
+
+    if (not kristall::globals().options.enable_link_prefetch or kristall::globals().options.offline_mode)
+        return;
+    if (target.scheme() != "gemini" and target.scheme() != "gopher")
+        return;
+
+    this->prefetch_url = target;
+    this->prefetch_timer.start();
+}
+
+void BrowserTab::cancelPrefetch()
+{
+    this->prefetch_timer.stop();
+    this->prefetch_url = QUrl { };
+
+    if (this->prefetch_request != nullptr and not this->prefetch_request->isFinished())
+        this->prefetch_request->cancel();
+    this->prefetch_request = nullptr;
+}
+
+void BrowserTab::on_prefetchTimeout()
+{
+    QUrl const url = this->prefetch_url;
+
+    // Pages that are requested with a client certificate are never cached,
+    // so there is no point in prefetching them. This also makes sure we
+    // don't reveal ourselves anonymously to a host we use an identity with.
+    if (this->current_identity.isValid())
+        return;
+    for (auto ident_ptr : kristall::globals().identities.allIdentities())
+    {
+        if (ident_ptr->isAutomaticallyEnabledOn(url))
+            return;
+    }
+
+    kristall::globals().cache.clean();
+    if (auto pg = kristall::globals().cache.find(url); pg != nullptr and not kristall::globals().cache.isExpired(*pg))
+        return;
+
+    this->prefetch_request = kristall::globals().network.request(
+        url,
+        ProtocolHandler::Default,
+        CryptoIdentity(),
+        NetworkRequest::Background);
+    if (this->prefetch_request == nullptr)
+        return;
+
+    // Only successful responses are cached, everything else
+    // (redirects, input, certificates, errors) is just dropped.
+    connect(this->prefetch_request, &NetworkRequest::requestComplete, this, [url](QByteArray const & data, QString const & mime_text) {
+        // Like in renderPage, only text documents are cached.
+        // CacheHandler::push skips items above the size threshold.
+        auto mime = MimeParser::parse(mime_text);
+        if (mime.is("text"))
+            kristall::globals().cache.push(url, data, mime);
+    });
+}
+
+void BrowserTab::revalidatePage(const QUrl &url, const QByteArray &body_hash)
+{
+    this->cancelRevalidation();
+
+    this->revalidate_request = kristall::globals().network.request(
+        url,
+        ProtocolHandler::Default,
+        CryptoIdentity(),
+        NetworkRequest::Background);
+    if (this->revalidate_request == nullptr)
+        return;
+
+    connect(this->revalidate_request, &NetworkRequest::requestComplete, this, [this, url, body_hash](QByteArray const & data, QString const & mime_text) {
+        auto mime = MimeParser::parse(mime_text);
+        if (not mime.is("text"))
+            return;
+
+        kristall::globals().cache.push(url, data, mime);
+
+        if (CachedPage::hashBody(data) == body_hash)
+            return;
+
+        // Only replace the page if the user is still looking at it
+        if (this->current_location.adjusted(QUrl::RemoveFragment) != url or this->isRequestInProgress())
+            return;
+
+        qDebug() << "cache: revalidated page has changed, updating view";
+
+        auto scroll = this->ui->text_browser->verticalScrollBar()->value();
+        this->was_read_from_cache = true;
+        this->on_requestComplete(data, mime);
+        this->ui->text_browser->verticalScrollBar()->setValue(scroll);
+    });
+}
+
+void BrowserTab::cancelRevalidation()
+{
+    if (this->revalidate_request != nullptr and not this->revalidate_request->isFinished())
+        this->revalidate_request->cancel();
+    this->revalidate_request = nullptr;
+}
+
+void BrowserTab::setCacheBanner(const QString &text)
+{
+    this->ui->cache_banner->setText(text);
+    this->ui->cache_banner->setVisible(not text.isEmpty());
+}
+
+bool BrowserTab::showCachedFallback(ProtocolHandler::NetworkError error, const QString &reason)
+{
+    switch (error)
+    {
+    case ProtocolHandler::HostNotFound:
+    case ProtocolHandler::Timeout:
+    case ProtocolHandler::HostLookupTimeout:
+    case ProtocolHandler::ConnectTimeout:
+    case ProtocolHandler::TlsHandshakeTimeout:
+    case ProtocolHandler::ResponseTimeout:
+    case ProtocolHandler::TransferTimeout:
+        break;
+    default:
+        return false;
+    }
+
+    auto pg = kristall::globals().cache.find(this->current_location);
+    if (pg == nullptr)
+        return false;
+
+    qDebug() << "cache: showing stale copy after network error:" << reason;
+
+    this->was_read_from_cache = true;
+    this->on_requestComplete(pg->body, pg->mime);
+    this->setCacheBanner(tr("%1 could not be reached (%2). Showing the copy cached on %3.")
+        .arg(this->current_location.host(), reason, QLocale().toString(pg->time_cached, QLocale::ShortFormat)));
+    this->updateUI();
+    return true;
 }
 
 void BrowserTab::on_back_button_clicked()
@@ -1269,7 +1864,7 @@ void BrowserTab::updateUI()
     this->ui->back_button->setEnabled(history.oneBackward(current_history_index).isValid());
     this->ui->forward_button->setEnabled(history.oneForward(current_history_index).isValid());
 
-    bool in_progress = (this->current_handler != nullptr) and this->current_handler->isInProgress();
+    bool in_progress = this->isRequestInProgress();
 
     this->ui->refresh_button->setVisible(not in_progress);
     this->ui->stop_button->setVisible(in_progress);
@@ -1395,10 +1990,14 @@ void BrowserTab::setUiDensity(UIDensity density)
 
 void BrowserTab::updatePageMargins()
 {
-    if (!this->current_document || !this->current_style.text_width_enabled)
+    // This is not necessarily the current_document, as
+    // streamed documents are displayed while being rendered.
+    QTextDocument * const document = this->ui->text_browser->document();
+
+    if (!document || !this->current_style.text_width_enabled)
         return;
 
-    QTextFrame *root = this->current_document->rootFrame();
+    QTextFrame *root = document->rootFrame();
     QTextFrameFormat fmt = root->frameFormat();
     int margin = std::max((this->width() - this->current_style.text_width) / 2,
         this->current_style.margin_h);
@@ -1406,7 +2005,7 @@ void BrowserTab::updatePageMargins()
     fmt.setRightMargin(margin);
     root->setFrameFormat(fmt);
 
-    this->ui->text_browser->setDocument(this->current_document.get());
+    this->ui->text_browser->setDocument(document);
 }
 
 void BrowserTab::refreshOptionalToolbarItems()
@@ -1473,62 +2072,85 @@ void BrowserTab::resetClientCertificate()
     this->disableClientCertificate();
 }
 
-void BrowserTab::addProtocolHandler(std::unique_ptr<ProtocolHandler> &&handler)
+void BrowserTab::connectRequest(NetworkRequest *request)
 {
-    connect(handler.get(), &ProtocolHandler::requestProgress, this, &BrowserTab::on_requestProgress);
-    connect(handler.get(), &ProtocolHandler::requestComplete, this,
+    connect(request, &NetworkRequest::requestProgress, this, &BrowserTab::on_requestProgress);
+    connect(request, &NetworkRequest::responseStarted, this, &BrowserTab::on_responseStarted);
+    connect(request, &NetworkRequest::responseData, this, &BrowserTab::on_responseData);
+    connect(request, &NetworkRequest::requestComplete, this,
         qOverload<QByteArray const &, QString const &>(&BrowserTab::on_requestComplete));
-    connect(handler.get(), &ProtocolHandler::requestStateChange, this, [this](RequestState state) {
-        emit this->requestStateChanged(state);
+    connect(request, &NetworkRequest::requestStateChange, this, [this, request](RequestState state) {
+        // The host asked us to slow down, so the wait is shown instead of an error
+        if(state == RequestState::Deferred)
+            this->retry_time = kristall::globals().network.backoffUntil(request->url());
         this->request_state = state;
+        emit this->requestStateChanged(state);
     });
-    connect(handler.get(), &ProtocolHandler::redirected, this, &BrowserTab::on_redirected);
-    connect(handler.get(), &ProtocolHandler::inputRequired, this, &BrowserTab::on_inputRequired);
-    connect(handler.get(), &ProtocolHandler::networkError, this, &BrowserTab::on_networkError);
-    connect(handler.get(), &ProtocolHandler::certificateRequired, this, &BrowserTab::on_certificateRequired);
-    connect(handler.get(), &ProtocolHandler::hostCertificateLoaded, this, &BrowserTab::on_hostCertificateLoaded);
-
-    this->protocol_handlers.emplace_back(std::move(handler));
+    connect(request, &NetworkRequest::requestCompleteFile, this, &BrowserTab::on_requestCompleteFile);
+    connect(request, &NetworkRequest::redirected, this, &BrowserTab::on_redirected);
+    connect(request, &NetworkRequest::inputRequired, this, &BrowserTab::on_inputRequired);
+    connect(request, &NetworkRequest::networkError, this, &BrowserTab::on_networkError);
+    connect(request, &NetworkRequest::certificateRequired, this, &BrowserTab::on_certificateRequired);
+    connect(request, &NetworkRequest::hostCertificateLoaded, this, &BrowserTab::on_hostCertificateLoaded);
 }
 
-bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions options, RequestFlags flags)
+void BrowserTab::cancelRequest()
 {
-    this->updateMouseCursor(true);
+    if(not this->isRequestInProgress())
+        return;
 
-    this->current_server_certificate = QSslCertificate { };
+    this->current_request->cancel();
+    this->current_request = nullptr;
 
-    this->was_read_from_cache = false;
+    this->request_state = RequestState::None;
+    emit this->requestStateChanged(RequestState::None);
+}
+
+bool BrowserTab::isRequestInProgress() const
+{
+    return (this->current_request != nullptr) and not this->current_request->isFinished();
+}
 
-    this->current_handler = nullptr;
-    for(auto & ptr : this->protocol_handlers)
+bool BrowserTab::startRequest(const QUrl &requested_url, ProtocolHandler::RequestOptions options, RequestFlags flags)
+{
+    // Go straight to the target of known permanent redirections
+    QUrl url = requested_url;
+    if (not this->current_identity.isValid())
     {
-        if(ptr->supportsScheme(url.scheme())) {
-            this->current_handler = ptr.get();
-            break;
+        QUrl const target = kristall::globals().redirects.resolve(requested_url);
+        if (target != requested_url and kristall::globals().protocols.isSchemeSupported(target.scheme()) == ProtocolSetup::Enabled)
+        {
+            // Remembered redirections are subject to the same policy as
+            // the ones sent by the server. If the user declines, the
+            // redirection is forgotten and the old location is requested.
+            if (this->confirmRedirection(requested_url, target))
+            {
+                qDebug() << "Following remembered redirection from" << requested_url << "to" << target;
+                url = target;
+            }
+            else
+            {
+                kristall::globals().redirects.remove(requested_url);
+            }
         }
     }
 
-    assert((this->current_handler != nullptr) and "If this error happens, someone forgot to add a new protocol handler class in the constructor. Shame on the programmer!");
+    // A new request always replaces the running one
+    this->cancelRequest();
 
-    auto const try_enable_certificate = [&]() -> bool {
-        if(this->current_identity.isValid()) {
-            if(not this->current_handler->enableClientCertificate(this->current_identity)) {
-                auto answer = QMessageBox::question(
-                    this,
-                    "Kristall",
-                    tr("You requested a %1-URL with a client certificate, but these are not supported for this scheme. Continue?").arg(url.scheme())
-                );
-                if(answer != QMessageBox::Yes)
-                    return false;
-                this->disableClientCertificate();
-            }
-        } else {
-            this->disableClientCertificate();
-        }
-        return true;
-    };
-    if(not try_enable_certificate())
-        return false;
+    this->progress_timer.stop();
+    this->throughput = 0.0;
+    this->throughput_sample_size = 0;
+    this->throughput_sample_time = this->timer.elapsed();
+
+    this->updateMouseCursor(true);
+
+    this->current_server_certificate = QSslCertificate { };
+
+    this->was_read_from_cache = false;
+    this->setCacheBanner(QString { });
+
+    this->resetStreamPreview();
 
     if(this->current_identity.isValid() and (url.host() != this->current_location.host())) {
         auto answer = QMessageBox::question(
@@ -1581,24 +2203,45 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
         }
     }
 
-    if(not try_enable_certificate())
-        return false;
+    if(this->current_identity.isValid() and not kristall::globals().network.supportsClientCertificates(url.scheme())) {
+        auto answer = QMessageBox::question(
+            this,
+            "Kristall",
+            tr("You requested a %1-URL with a client certificate, but these are not supported for this scheme. Continue?").arg(url.scheme())
+        );
+        if(answer != QMessageBox::Yes) {
+            this->updateMouseCursor(false);
+            return false;
+        }
+        this->disableClientCertificate();
+    }
 
     QString urlstr = url.toString(QUrl::FullyEncoded);
 
-    this->is_internal_location = (url.scheme() == "about" || url.scheme() == "file");
+    this->is_internal_location = (url.scheme() == "about" || url.scheme() == "file" || url.scheme() == "kristall+cache");
     this->current_location = url;
     this->setUrlBarText(urlstr);
 
-    this->network_timeout_timer.start(kristall::globals().options.network_timeout);
-
     const auto req = [this, &url, &options]()
     {
-        return this->current_handler->startRequest(url.adjusted(QUrl::RemoveFragment), options);
+        this->current_request = kristall::globals().network.request(
+            url.adjusted(QUrl::RemoveFragment),
+            options,
+            this->current_identity,
+            NetworkRequest::Foreground);
+        if(this->current_request == nullptr)
+            return false;
+        this->connectRequest(this->current_request);
+        return true;
     };
 
-    if ((flags & RequestFlags::DontReadFromCache) ||
-        this->current_identity.isValid())
+    // While offline, the cache is the only source of pages
+    bool const is_offline = kristall::globals().options.offline_mode
+        and not this->is_internal_location;
+
+    if (not is_offline and
+        ((flags & RequestFlags::DontReadFromCache) ||
+        this->current_identity.isValid()))
     {
         return req();
     }
@@ -1616,6 +2259,15 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
             pg->scroll_pos != -1)
             this->ui->text_browser->verticalScrollBar()->setValue(pg->scroll_pos);
 
+        if (is_offline) {
+            this->setCacheBanner(tr("You are working offline. This page was cached on %1.")
+                .arg(QLocale().toString(pg->time_cached, QLocale::ShortFormat)));
+        }
+        // Expired pages are still shown, but refreshed in the background
+        else if (kristall::globals().cache.isExpired(*pg)) {
+            this->revalidatePage(pg->url.adjusted(QUrl::RemoveFragment), pg->body_hash);
+        }
+
         return true;
     }
     else
@@ -1640,6 +2292,8 @@ bool BrowserTab::enableClientCertificate(const CryptoIdentity &ident)
         this->disableClientCertificate();
         return false;
     }
+    // Resumed sessions would link the requests made before and after the switch
+    kristall::globals().ssl_sessions.clear();
     this->current_identity = ident;
     this->ui->enable_client_cert_button->setChecked(true);
     return true;
@@ -1647,9 +2301,8 @@ bool BrowserTab::enableClientCertificate(const CryptoIdentity &ident)
 
 void BrowserTab::disableClientCertificate()
 {
-    for(auto & handler : this->protocol_handlers) {
-        handler->disableClientCertificate();
-    }
+    if (this->current_identity.isValid())
+        kristall::globals().ssl_sessions.clear();
     this->ui->enable_client_cert_button->setChecked(false);
     this->current_identity = CryptoIdentity();
 }
@@ -1726,7 +2379,7 @@ void BrowserTab::on_text_browser_customContextMenuRequested(const QPoint pos)
         });
         forward->setEnabled(history.oneForward(current_history_index).isValid());
 
-        if (this->current_handler && this->current_handler->isInProgress()) {
+        if (this->isRequestInProgress()) {
             menu.addAction(QIcon::fromTheme("process-stop"), tr("Stop"), [this]() {
                 this->on_stop_button_clicked();
             });
@@ -10,14 +10,19 @@
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QTextCursor>
+#include <QPointer>
+#include <QDateTime>
 
 #include "documentoutlinemodel.hpp"
 #include "tabbrowsinghistory.hpp"
 #include "renderers/geminirenderer.hpp"
+#include "renderers/gophermaprenderer.hpp"
+#include "renderers/plaintextrenderer.hpp"
 
 #include "cryptoidentity.hpp"
 
 #include "protocolhandler.hpp"
+#include "networkservice.hpp"
 
 #include "mimeparser.hpp"
 
@@ -36,8 +41,22 @@ struct DocumentStats
     qint64 file_size = 0;
     bool loaded_from_cache = false;
 
+    //! True while the document is still being transferred
+    bool is_in_progress = false;
+    //! Expected size of the document in bytes, -1 if unknown
+    qint64 expected_size = -1;
+    //! Transfer rate in bytes per second, 0 if unknown
+    qint64 throughput = 0;
+    //! Estimated time until the transfer is complete in ms, -1 if unknown
+    int eta = -1;
+
+    //! Phase timings of the network request, invalid for cached and local documents
+    RequestTimings timings;
+    //! Time it took to render the document in ms
+    int render_time = 0;
+
     bool isValid() const {
-        return mime_type.isValid();
+        return mime_type.isValid() or is_in_progress;
     }
 };
 
@@ -89,6 +108,8 @@ public:
 
     void openSourceView();
 
+    void openTimingView();
+
     void renderPage(const QByteArray & data, const MimeType & mime);
 
     void rerenderPage();
@@ -122,6 +143,8 @@ private slots:
 
     void on_url_bar_escapePressed();
 
+    void on_url_bar_textEdited(QString const & text);
+
     void on_url_bar_focused();
 
     void on_url_bar_blurred();
@@ -162,16 +185,25 @@ private slots:
 
 private: // network slots
 
-    void on_requestProgress(qint64 transferred);
+    void on_requestProgress(qint64 transferred, qint64 total);
+    void on_responseStarted(QString const & mime);
+    void on_responseData(QByteArray const & chunk);
     void on_requestComplete(QByteArray const & data, QString const & mime);
     void on_requestComplete(QByteArray const & data, MimeType const & mime);
+    void on_requestCompleteFile(QString const & file_name, QString const & mime);
     void on_redirected(QUrl uri, bool is_permanent);
     void on_inputRequired(QString const & user_query, bool is_sensitive);
     void on_networkError(ProtocolHandler::NetworkError error, QString const & reason);
     void on_certificateRequired(QString const & info);
     void on_hostCertificateLoaded(QSslCertificate const & cert);
 
-    void on_networkTimeout();
+    void on_progressTimeout();
+
+    void on_streamRenderTimeout();
+
+    void on_prefetchTimeout();
+
+    void on_preconnectTimeout();
 
 private: // ui slots
     void on_focusSearchbar();
@@ -179,6 +211,15 @@ private: // ui slots
 private:
     void setErrorMessage(QString const & msg);
 
+    //! Asks the user whether the redirection from `from` to `to` may be
+    //! followed, as configured by the redirection policy.
+    bool confirmRedirection(QUrl const & from, QUrl const & to);
+
+    //! Returns the question the redirection policy asks before the
+    //! redirection from `from` to `to` is followed, or an empty string
+    //! if it is followed without asking.
+    QString redirectionQuestion(QUrl const & from, QUrl const & to) const;
+
     void pushToHistory(QUrl const & url);
 
     void updateUI();
@@ -187,17 +228,53 @@ private:
 
     void resetClientCertificate();
 
-    void addProtocolHandler(std::unique_ptr<ProtocolHandler> && handler);
+    //! Subscribes the tab to the signals of `request`.
+    void connectRequest(NetworkRequest * request);
 
-    template<typename T>
-    void addProtocolHandler() {
-        this->addProtocolHandler(std::make_unique<T>());
-    }
+    //! Cancels the running request, if any.
+    void cancelRequest();
+
+    bool isRequestInProgress() const;
 
-    bool startRequest(QUrl const & url, ProtocolHandler::RequestOptions options, RequestFlags flags = RequestFlags::None);
+    bool startRequest(QUrl const & requested_url, ProtocolHandler::RequestOptions options, RequestFlags flags = RequestFlags::None);
 
     void updateMouseCursor(bool waiting);
 
+    //! Renders the part of the response that was streamed so far.
+    void renderStreamPreview();
+
+    //! Displays the live document of an incremental renderer.
+    void showStreamDocument(QTextDocument * document);
+
+    //! Drops all state of the currently streamed response.
+    void resetStreamPreview();
+
+    //! Resolves the hosts of the links in the current document ahead
+    //! of time, so following a link doesn't wait for DNS.
+    void prefetchLinkedHosts();
+
+    //! Starts the dwell timer for prefetching the hovered link `url`.
+    //! An invalid url cancels the pending prefetch.
+    void schedulePrefetch(QUrl const & url);
+
+    void cancelPrefetch();
+
+    //! Refreshes the expired cache entry for `url` in the background.
+    //! The view is updated if the page is still shown and its body
+    //! no longer matches `body_hash`.
+    void revalidatePage(QUrl const & url, QByteArray const & body_hash);
+
+    void cancelRevalidation();
+
+    //! Shows `text` in the banner above the document, which explains
+    //! why a cached copy is shown. An empty text hides the banner.
+    void setCacheBanner(QString const & text);
+
+    //! Shows the cached copy of the current location after the request
+    //! failed with `error`, if the error is caused by connectivity and a
+    //! copy is cached. Returns true if the copy is shown.
+    bool showCachedFallback(ProtocolHandler::NetworkError error, QString const & reason);
+
     bool enableClientCertificate(CryptoIdentity const & ident);
     void disableClientCertificate();
 
@@ -212,9 +289,7 @@ public:
     MainWindow * mainWindow;
     QUrl current_location;
 
-    std::vector<std::unique_ptr<ProtocolHandler>> protocol_handlers;
-
-    ProtocolHandler * current_handler;
+    QPointer<NetworkRequest> current_request;
 
     int redirection_count = 0;
 
@@ -238,7 +313,39 @@ public:
 
     DocumentStats current_stats;
 
-    QTimer network_timeout_timer;
+    //! Progress reports are coalesced and applied once per frame
+    QTimer progress_timer;
+    qint64 progress_transferred = 0;
+    qint64 progress_total = -1;
+
+    //! Smoothed transfer rate in bytes per second
+    double throughput = 0.0;
+    qint64 throughput_sample_size = 0;
+    qint64 throughput_sample_time = 0;
+
+    //! Body of the response that is currently streamed in
+    QByteArray stream_buffer;
+    bool is_streaming = false;
+    bool stream_preview_shown = false;
+    QTimer stream_render_timer;
+
+    //! Renders streamed gemtext documents into the live document
+    std::unique_ptr<IncrementalGeminiRenderer> stream_renderer;
+    //! Renders streamed gopher menus into the live document
+    std::unique_ptr<IncrementalGophermapRenderer> stream_gophermap_renderer;
+    //! Renders all other streamed text into the live document
+    std::unique_ptr<IncrementalPlainTextRenderer> stream_plaintext_renderer;
+
+    //! Link that is fetched into the cache while being hovered
+    QUrl prefetch_url;
+    QTimer prefetch_timer;
+    QPointer<NetworkRequest> prefetch_request;
+
+    //! Connects to the host typed into the url bar
+    QTimer preconnect_timer;
+
+    //! Refreshes a stale page that was shown from the cache
+    QPointer<NetworkRequest> revalidate_request;
 
     QTextCursor current_search_position;
 
@@ -253,6 +360,8 @@ public:
     bool lazy_loading = false;
 
     RequestState request_state;
+    //! When a deferred request is sent again
+    QDateTime retry_time;
 
     DocumentStyle current_style;
 };
@@ -3,6 +3,12 @@
 #include "ioutil.hpp"
 
 #include <QDebug>
+#include <QCryptographicHash>
+
+QByteArray CachedPage::hashBody(const QByteArray &body)
+{
+    return QCryptographicHash::hash(body, QCryptographicHash::Sha1);
+}
 
 void CacheHandler::push(const QUrl &url, const QByteArray &body, const MimeType &mime)
 {
@@ -29,6 +35,7 @@ void CacheHandler::push(const QUrl &url, const QByteArray &body, const MimeType
         pg->body = body;
         pg->mime = mime;
         pg->time_cached = QDateTime::currentDateTime();
+        pg->body_hash = CachedPage::hashBody(body);
         return;
     }
 
@@ -80,13 +87,23 @@ void CacheHandler::clean()
     // Don't clean anything if we have unlimited item life.
     if (kristall::globals().options.cache_unlimited_life) return;
 
+    // Expired items are all there is while offline
+    if (kristall::globals().options.offline_mode) return;
+
+    // Expired items are still shown while they are revalidated,
+    // but only until they reach the maximum stale age.
+    int life = kristall::globals().options.cache_life * 60;
+    if (kristall::globals().options.cache_revalidate)
+        life += max_stale_age;
+
+    QDateTime const cutoff = QDateTime::currentDateTime().addSecs(-life);
+
     // Find list of keys to delete
     std::vector<QString> vec;
     for (auto&& i : this->page_cache)
     {
         // Check if this cache item is expired.
-        if (QDateTime::currentDateTime() > i.second->time_cached
-            .addSecs(kristall::globals().options.cache_life * 60))
+        if (i.second->time_cached < cutoff)
         {
             vec.emplace_back(std::move(i.first));
         }
@@ -103,6 +120,14 @@ void CacheHandler::clean()
     if (count) qDebug() << "cache: cleaned " << count << " expired pages out of cache";
 }
 
+bool CacheHandler::isExpired(const CachedPage &page) const
+{
+    if (kristall::globals().options.cache_unlimited_life)
+        return false;
+    return QDateTime::currentDateTime() > page.time_cached
+        .addSecs(kristall::globals().options.cache_life * 60);
+}
+
 CacheMap const& CacheHandler::getPages() const
 {
     return this->page_cache;
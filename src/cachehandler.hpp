@@ -39,13 +39,19 @@ struct CachedPage
 
     QDateTime time_cached;
 
+    //! Hash of `body`, used to detect if a revalidated page has changed
+    QByteArray body_hash;
+
     // also: maybe compress page contents? May test
     // to see if it's worth it
 
     CachedPage(const QUrl &url, const QByteArray &body,
         const MimeType &mime, const QDateTime &cached)
-        : url(url), body(body), mime(mime), scroll_pos(-1), time_cached(cached)
+        : url(url), body(body), mime(mime), scroll_pos(-1), time_cached(cached),
+          body_hash(hashBody(body))
     {}
+
+    static QByteArray hashBody(QByteArray const & body);
 };
 
 // Maybe unordered_map isn't the best type for this?
@@ -54,6 +60,9 @@ typedef std::unordered_map<QString, std::shared_ptr<CachedPage>> CacheMap;
 class CacheHandler
 {
 public:
+    //! Time in seconds an expired page is kept for revalidation
+    static constexpr int max_stale_age = 24 * 60 * 60;
+
     void push(QUrl const & url, QByteArray const & body, MimeType const & mime);
 
     std::shared_ptr<CachedPage> find(QUrl const &url);
@@ -62,8 +71,13 @@ public:
 
     int size();
 
+    //! Removes expired pages. When revalidation is enabled, expired pages
+    //! are kept for up to `max_stale_age`, so they can still be shown.
     void clean();
 
+    //! Returns true if `page` is older than the configured item life.
+    bool isExpired(CachedPage const & page) const;
+
     CacheMap const& getPages() const;
 
 private:
@@ -0,0 +1,198 @@
+#include "connectionpool.hpp"
+#include "hostconnector.hpp"
+#include "kristall.hpp"
+#include "protocols/geminiclient.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ConnectionPool::ConnectionPool(QObject *parent) : QObject(parent)
+{
+    this->expiry_timer.setInterval(1000);
+    connect(&this->expiry_timer, &QTimer::timeout, this, &ConnectionPool::on_expiryTimeout);
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    this->clear();
+}
+
+void ConnectionPool::preconnect(const QUrl &url)
+{
+    if(not kristall::globals().options.enable_preconnect or kristall::globals().options.offline_mode)
+        return;
+    if(url.scheme() != "gemini" or url.host().isEmpty())
+        return;
+    if(kristall::globals().protocols.isSchemeSupported(url.scheme()) != ProtocolSetup::Enabled)
+        return;
+
+    // Requests with a client certificate never use pooled connections,
+    // and we don't want to reveal ourselves anonymously to those hosts.
+    for (auto ident_ptr : kristall::globals().identities.allIdentities())
+    {
+        if (ident_ptr->isAutomaticallyEnabledOn(url))
+            return;
+    }
+
+    QString const host = url.host();
+    quint16 const port = url.port(1965);
+    if(this->find(host, port) != nullptr)
+        return;
+
+    if(this->size() >= max_connections)
+        this->drop(this->connections.front().get());
+
+    auto connection = std::make_unique<Connection>();
+    Connection * const conn = connection.get();
+    conn->url.setScheme("gemini");
+    conn->url.setHost(host);
+    conn->url.setPort(port);
+    conn->connector = new HostConnector(this);
+    conn->idle_time.start();
+    this->connections.push_back(std::move(connection));
+
+    connect(conn->connector, &HostConnector::connected, this, [this, conn](QAbstractSocket * socket) {
+        this->on_connected(conn, socket);
+    });
+    connect(conn->connector, &HostConnector::connectionFailed, this, [this, conn]() {
+        this->drop(conn);
+    });
+
+    auto const ssl_config = GeminiClient::createSslConfiguration(conn->url, QSslCertificate { }, QSslKey { });
+    conn->connector->connectToHost(host, port, [ssl_config, host]() -> QAbstractSocket * {
+        auto * ssl_socket = new QSslSocket();
+        ssl_socket->setSslConfiguration(ssl_config);
+        ssl_socket->setPeerVerifyName(host);
+        return ssl_socket;
+    });
+
+    this->open_count += 1;
+    if(not this->expiry_timer.isActive())
+        this->expiry_timer.start();
+}
+
+QSslSocket *ConnectionPool::take(const QString &host, quint16 port, QList<QSslError> &ssl_errors)
+{
+    Connection * conn = this->find(host, port);
+    if(conn == nullptr or not conn->is_ready)
+        return nullptr;
+
+    QSslSocket * socket = conn->socket;
+    socket->disconnect(this);
+    ssl_errors = conn->ssl_errors;
+
+    conn->socket = nullptr;
+    this->drop(conn);
+
+    this->hit_count += 1;
+    return socket;
+}
+
+void ConnectionPool::clear()
+{
+    while(not this->connections.empty())
+        this->drop(this->connections.back().get());
+}
+
+void ConnectionPool::on_expiryTimeout()
+{
+    // Connections that are still being opened expire as well,
+    // so an unresponsive host doesn't occupy the pool.
+    std::vector<Connection *> expired;
+    for(auto const & conn : this->connections)
+    {
+        if(conn->idle_time.hasExpired(idle_timeout))
+            expired.push_back(conn.get());
+    }
+    for(auto * conn : expired)
+        this->drop(conn);
+
+    if(this->connections.empty())
+        this->expiry_timer.stop();
+}
+
+ConnectionPool::Connection *ConnectionPool::find(const QString &host, quint16 port)
+{
+    for(auto const & conn : this->connections)
+    {
+        if(conn->url.host().compare(host, Qt::CaseInsensitive) == 0 and conn->url.port() == port)
+            return conn.get();
+    }
+    return nullptr;
+}
+
+void ConnectionPool::on_connected(Connection *conn, QAbstractSocket *connected_socket)
+{
+    conn->connector->deleteLater();
+    conn->connector = nullptr;
+
+    conn->socket = qobject_cast<QSslSocket*>(connected_socket);
+    assert(conn->socket != nullptr);
+
+    connect(conn->socket, &QSslSocket::encrypted, this, [this, conn]() {
+        conn->is_ready = true;
+        conn->idle_time.start();
+
+        auto const ssl_config = conn->socket->sslConfiguration();
+        kristall::globals().ssl_sessions.store(
+            conn->url.host(),
+            quint16(conn->url.port()),
+            ssl_config.sessionTicket(),
+            ssl_config.sessionTicketLifeTimeHint());
+    });
+    connect(conn->socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors), this, [this, conn](QList<QSslError> const & errors) {
+        this->on_sslErrors(conn, errors);
+    });
+    connect(conn->socket, &QSslSocket::disconnected, this, [this, conn]() {
+        this->drop(conn);
+    });
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(conn->socket, &QSslSocket::errorOccurred, this, [this, conn](QAbstractSocket::SocketError) {
+        this->drop(conn);
+    });
+#else
+    connect(conn->socket, QOverload<QAbstractSocket::SocketError>::of(&QSslSocket::error), this, [this, conn](QAbstractSocket::SocketError) {
+        this->drop(conn);
+    });
+#endif
+
+    conn->socket->startClientEncryption();
+}
+
+void ConnectionPool::on_sslErrors(Connection *conn, const QList<QSslError> &errors)
+{
+    // Certificates that aren't pinned yet are only trusted when the connection
+    // is used, otherwise merely hovering a link would pin its host on first use.
+    for(auto const & err : errors)
+    {
+        if(not SslTrust::isTrustRelated(err.error()) and err.error() != QSslError::UnableToVerifyFirstCertificate) {
+            this->drop(conn);
+            return;
+        }
+    }
+
+    if(kristall::globals().trust.gemini.isMistrusted(conn->url, conn->socket->peerCertificate())) {
+        this->drop(conn);
+        return;
+    }
+
+    conn->ssl_errors = errors;
+    conn->socket->ignoreSslErrors(errors);
+}
+
+void ConnectionPool::drop(Connection *conn)
+{
+    auto it = std::find_if(this->connections.begin(), this->connections.end(), [conn](std::unique_ptr<Connection> const & ptr) {
+        return ptr.get() == conn;
+    });
+    if(it == this->connections.end())
+        return;
+
+    if(conn->connector != nullptr) {
+        conn->connector->abort();
+        conn->connector->deleteLater();
+    }
+    HostConnector::closeSocket(conn->socket);
+
+    this->connections.erase(it);
+}
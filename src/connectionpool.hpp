@@ -0,0 +1,85 @@
+#ifndef CONNECTIONPOOL_HPP
+#define CONNECTIONPOOL_HPP
+
+#include <QObject>
+#include <QSslSocket>
+#include <QSslError>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QUrl>
+#include <QList>
+
+#include <memory>
+#include <vector>
+
+class HostConnector;
+
+//! Opens TLS connections to Gemini hosts that are likely visited next,
+//! e.g. while an address is typed or a link is hovered. A request to
+//! such a host then reuses the connection and skips the connection
+//! setup and handshake. Only anonymous connections are pooled.
+class ConnectionPool : public QObject
+{
+    Q_OBJECT
+public:
+    //! Time an unused connection is kept open (in ms)
+    static constexpr int idle_timeout = 10000;
+
+    //! Maximum number of connections that are kept or being opened
+    static constexpr int max_connections = 4;
+
+    explicit ConnectionPool(QObject * parent = nullptr);
+
+    ~ConnectionPool() override;
+
+    //! Connects to the host of `url` in the background, unless pre-connecting
+    //! is disabled or a connection to the host is already open or pending.
+    void preconnect(QUrl const & url);
+
+    //! Removes an established connection to the given host from the pool and
+    //! returns it, or returns nullptr if none is ready. The caller takes
+    //! ownership of the socket.
+    //! `ssl_errors` receives the errors ignored during the handshake. Trust
+    //! in the host is not established yet, so the caller has to check them.
+    QSslSocket * take(QString const & host, quint16 port, QList<QSslError> & ssl_errors);
+
+    //! Closes all pooled connections.
+    void clear();
+
+    int size() const { return int(connections.size()); }
+
+    int hits() const { return hit_count; }
+    int opened() const { return open_count; }
+
+private slots:
+    void on_expiryTimeout();
+
+private:
+    struct Connection
+    {
+        QUrl url;
+        HostConnector * connector = nullptr;
+        QSslSocket * socket = nullptr;
+        QList<QSslError> ssl_errors;
+        bool is_ready = false;
+        QElapsedTimer idle_time;
+    };
+
+    Connection * find(QString const & host, quint16 port);
+
+    void on_connected(Connection * connection, QAbstractSocket * socket);
+
+    void on_sslErrors(Connection * connection, QList<QSslError> const & errors);
+
+    //! Closes the connection and removes it from the pool.
+    void drop(Connection * connection);
+
+private:
+    std::vector<std::unique_ptr<Connection>> connections;
+    QTimer expiry_timer;
+
+    int hit_count = 0;
+    int open_count = 0;
+};
+
+#endif // CONNECTIONPOOL_HPP
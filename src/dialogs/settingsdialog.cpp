@@ -365,6 +365,10 @@ void SettingsDialog::setOptions(const GenericSettings &options)
     }
 
     this->ui->network_timeout->setValue(this->current_options.network_timeout);
+    this->ui->spill_threshold->setValue(this->current_options.spill_threshold);
+    this->ui->download_limit->setValue(this->current_options.download_limit);
+    this->ui->enable_preconnect->setChecked(this->current_options.enable_preconnect);
+    this->ui->gopher_mirror_racing->setChecked(this->current_options.gopher_mirror_racing);
 
     this->ui->enable_home_btn->setChecked(this->current_options.enable_home_btn);
     this->ui->enable_newtab_btn->setChecked(this->current_options.enable_newtab_btn);
@@ -372,10 +376,14 @@ void SettingsDialog::setOptions(const GenericSettings &options)
     this->ui->enable_parent_btn->setChecked(this->current_options.enable_parent_btn);
 
     this->ui->cache_limit->setValue(this->current_options.cache_limit);
+    this->ui->http_cache_limit->setValue(this->current_options.http_cache_limit);
     this->ui->cache_threshold->setValue(this->current_options.cache_threshold);
     this->ui->cache_life->setValue(this->current_options.cache_life);
     this->ui->enable_unlimited_cache_life->setChecked(this->current_options.cache_unlimited_life);
     this->ui->cache_life->setEnabled(!this->current_options.cache_unlimited_life);
+    this->ui->enable_cache_revalidation->setChecked(this->current_options.cache_revalidate);
+    this->ui->enable_cache_revalidation->setEnabled(!this->current_options.cache_unlimited_life);
+    this->ui->enable_link_prefetch->setChecked(this->current_options.enable_link_prefetch);
 
     this->ui->session_restore_behaviour->setCurrentIndex(0);
     for(int i = 0; i < this->ui->session_restore_behaviour->count(); ++i)
@@ -933,6 +941,26 @@ void SettingsDialog::on_network_timeout_valueChanged(int timeout)
     this->current_options.network_timeout = timeout;
 }
 
+void SettingsDialog::on_spill_threshold_valueChanged(int threshold)
+{
+    this->current_options.spill_threshold = threshold;
+}
+
+void SettingsDialog::on_download_limit_valueChanged(int limit)
+{
+    this->current_options.download_limit = limit;
+}
+
+void SettingsDialog::on_enable_preconnect_clicked(bool checked)
+{
+    this->current_options.enable_preconnect = checked;
+}
+
+void SettingsDialog::on_gopher_mirror_racing_clicked(bool checked)
+{
+    this->current_options.gopher_mirror_racing = checked;
+}
+
 void SettingsDialog::on_enable_home_btn_clicked(bool checked)
 {
     this->current_options.enable_home_btn = checked;
@@ -958,6 +986,11 @@ void SettingsDialog::on_cache_limit_valueChanged(int limit)
     this->current_options.cache_limit = limit;
 }
 
+void SettingsDialog::on_http_cache_limit_valueChanged(int limit)
+{
+    this->current_options.http_cache_limit = limit;
+}
+
 void SettingsDialog::on_cache_threshold_valueChanged(int thres)
 {
     this->current_options.cache_threshold = thres;
@@ -972,6 +1005,17 @@ void SettingsDialog::on_enable_unlimited_cache_life_clicked(bool checked)
 {
     this->current_options.cache_unlimited_life = checked;
     this->ui->cache_life->setEnabled(!checked);
+    this->ui->enable_cache_revalidation->setEnabled(!checked);
+}
+
+void SettingsDialog::on_enable_cache_revalidation_clicked(bool checked)
+{
+    this->current_options.cache_revalidate = checked;
+}
+
+void SettingsDialog::on_enable_link_prefetch_clicked(bool checked)
+{
+    this->current_options.enable_link_prefetch = checked;
 }
 
 void SettingsDialog::on_strip_nav_on_clicked()
@@ -162,15 +162,26 @@ private slots:
 
     void on_network_timeout_valueChanged(int arg1);
 
+    void on_spill_threshold_valueChanged(int arg1);
+
+    void on_download_limit_valueChanged(int arg1);
+
+    void on_enable_preconnect_clicked(bool checked);
+
+    void on_gopher_mirror_racing_clicked(bool checked);
+
     void on_enable_home_btn_clicked(bool arg1);
     void on_enable_newtab_btn_clicked(bool arg1);
     void on_enable_root_btn_clicked(bool arg1);
     void on_enable_parent_btn_clicked(bool arg1);
 
     void on_cache_limit_valueChanged(int limit);
+    void on_http_cache_limit_valueChanged(int limit);
     void on_cache_threshold_valueChanged(int thres);
     void on_cache_life_valueChanged(int life);
     void on_enable_unlimited_cache_life_clicked(bool checked);
+    void on_enable_cache_revalidation_clicked(bool checked);
+    void on_enable_link_prefetch_clicked(bool checked);
 
     void on_strip_nav_on_clicked();
 
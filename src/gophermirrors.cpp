@@ -0,0 +1,36 @@
+#include "gophermirrors.hpp"
+
+QList<QUrl> GopherMirrors::find(const QUrl &url) const
+{
+    return this->mirrors.value(key(url));
+}
+
+void GopherMirrors::add(const QUrl &url, const QUrl &mirror)
+{
+    if(not url.isValid() or not mirror.isValid() or key(url) == key(mirror))
+        return;
+
+    auto const url_key = key(url);
+    auto it = this->mirrors.find(url_key);
+    if(it == this->mirrors.end())
+    {
+        if(this->mirrors.size() >= max_entries)
+            this->mirrors.remove(this->order.takeFirst());
+        it = this->mirrors.insert(url_key, QList<QUrl> { });
+        this->order.append(url_key);
+    }
+
+    if(it->size() < max_mirrors and not it->contains(mirror))
+        it->append(mirror);
+}
+
+void GopherMirrors::clear()
+{
+    this->mirrors.clear();
+    this->order.clear();
+}
+
+QString GopherMirrors::key(const QUrl &url)
+{
+    return url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment);
+}
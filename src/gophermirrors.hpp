@@ -0,0 +1,39 @@
+#ifndef GOPHERMIRRORS_HPP
+#define GOPHERMIRRORS_HPP
+
+#include <QUrl>
+#include <QString>
+#include <QHash>
+#include <QList>
+
+//! Remembers the alternate servers ('+' entries) listed for the items
+//! of gopher menus, so a request for an item can race all of its
+//! mirrors and use the first one that answers.
+class GopherMirrors
+{
+public:
+    //! Maximum number of items with known mirrors
+    static constexpr int max_entries = 1024;
+
+    //! Maximum number of mirrors remembered per item
+    static constexpr int max_mirrors = 3;
+
+    //! Returns the known mirrors of `url`, without `url` itself.
+    QList<QUrl> find(QUrl const & url) const;
+
+    //! Remembers `mirror` as an alternate location of `url`.
+    void add(QUrl const & url, QUrl const & mirror);
+
+    void clear();
+
+    int size() const { return mirrors.size(); }
+
+private:
+    static QString key(QUrl const & url);
+
+    QHash<QString, QList<QUrl>> mirrors;
+    //! Keys in insertion order, the oldest ones are dropped first
+    QList<QString> order;
+};
+
+#endif // GOPHERMIRRORS_HPP
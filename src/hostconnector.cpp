@@ -0,0 +1,217 @@
+#include "hostconnector.hpp"
+#include "kristall.hpp"
+
+#include <QDebug>
+
+namespace
+{
+    int open_socket_count = 0;
+
+    //! Child of each created socket, counts the sockets that are alive.
+    //! Unlike the destroyed signal it survives disconnecting the socket.
+    struct SocketTracker : QObject
+    {
+        explicit SocketTracker(QObject * socket) : QObject(socket) {
+            open_socket_count += 1;
+        }
+        ~SocketTracker() override {
+            open_socket_count -= 1;
+        }
+    };
+}
+
+HostConnector::HostConnector(QObject *parent) : QObject(parent)
+{
+    this->attempt_timer.setSingleShot(true);
+    this->attempt_timer.setInterval(connection_attempt_delay);
+    connect(&this->attempt_timer, &QTimer::timeout, this, &HostConnector::startNextAttempt);
+
+    this->clock.start();
+}
+
+HostConnector::~HostConnector()
+{
+    this->abort();
+}
+
+void HostConnector::connectToHost(const QString &host, quint16 port, const SocketFactory &factory)
+{
+    this->abort();
+
+    this->factory = factory;
+    this->host = host;
+    this->port = port;
+    this->is_connecting = true;
+    this->last_error = QAbstractSocket::UnknownSocketError;
+    this->last_error_string.clear();
+
+    auto const current_generation = ++this->generation;
+    kristall::globals().resolver.resolve(host, this, [this, current_generation](QHostInfo const & info) {
+        if(not this->is_connecting or current_generation != this->generation)
+            return;
+
+        if(info.error() != QHostInfo::NoError or info.addresses().isEmpty()) {
+            this->fail(QAbstractSocket::HostNotFoundError, info.errorString());
+            return;
+        }
+
+        emit this->hostFound();
+
+        this->pending_addresses = interleave(info.addresses());
+        this->startNextAttempt();
+    });
+}
+
+void HostConnector::abort()
+{
+    this->is_connecting = false;
+    this->attempt_timer.stop();
+    this->pending_addresses.clear();
+    this->dropAttempts();
+}
+
+int HostConnector::openSockets()
+{
+    return open_socket_count;
+}
+
+void HostConnector::disposeSocket(QAbstractSocket *socket)
+{
+    if(socket == nullptr)
+        return;
+    socket->disconnect();
+    socket->abort();
+    socket->deleteLater();
+}
+
+void HostConnector::closeSocket(QAbstractSocket *socket)
+{
+    if(socket == nullptr)
+        return;
+    socket->disconnect();
+
+    if(socket->state() == QAbstractSocket::UnconnectedState) {
+        socket->deleteLater();
+        return;
+    }
+
+    connect(socket, &QAbstractSocket::disconnected, socket, &QObject::deleteLater);
+    QTimer::singleShot(close_timeout, socket, [socket]() {
+        socket->abort();
+        socket->deleteLater();
+    });
+
+    // Sends the TLS close_notify for secure sockets
+    socket->disconnectFromHost();
+}
+
+void HostConnector::startNextAttempt()
+{
+    if(not this->is_connecting or this->pending_addresses.isEmpty())
+        return;
+
+    QHostAddress const address = this->pending_addresses.takeFirst();
+
+    QAbstractSocket * socket = this->factory();
+    new SocketTracker(socket);
+    this->attempts.append(socket);
+
+    this->attempt_start.insert(socket, this->clock.elapsed());
+
+    connect(socket, &QAbstractSocket::connected, this, [this, socket]() {
+        this->on_attemptConnected(socket);
+    });
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(socket, &QAbstractSocket::errorOccurred, this, [this, socket](QAbstractSocket::SocketError) {
+        this->on_attemptFailed(socket);
+    });
+#else
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, [this, socket](QAbstractSocket::SocketError) {
+        this->on_attemptFailed(socket);
+    });
+#endif
+
+    socket->connectToHost(address, this->port);
+
+    // The next address gets its chance if this one doesn't answer quickly
+    if(not this->pending_addresses.isEmpty())
+        this->attempt_timer.start();
+}
+
+void HostConnector::on_attemptConnected(QAbstractSocket *socket)
+{
+    if(not this->is_connecting)
+        return;
+
+    // Establishing a TCP connection takes one round trip
+    kristall::globals().timings.recordRoundTrip(this->host, this->clock.elapsed() - this->attempt_start.value(socket));
+
+    this->attempts.removeOne(socket);
+    this->attempt_start.remove(socket);
+    socket->disconnect(this);
+
+    this->abort();
+
+    emit this->connected(socket);
+}
+
+void HostConnector::on_attemptFailed(QAbstractSocket *socket)
+{
+    if(not this->is_connecting)
+        return;
+
+    this->last_error = socket->error();
+    this->last_error_string = socket->errorString();
+
+    qDebug() << "connection to" << socket->peerAddress() << "failed:" << this->last_error_string;
+
+    this->attempts.removeOne(socket);
+    this->attempt_start.remove(socket);
+    disposeSocket(socket);
+
+    if(not this->pending_addresses.isEmpty()) {
+        // Don't wait for the delay if we already know this address is broken
+        this->attempt_timer.stop();
+        this->startNextAttempt();
+    }
+    else if(this->attempts.isEmpty()) {
+        this->fail(this->last_error, this->last_error_string);
+    }
+}
+
+void HostConnector::fail(QAbstractSocket::SocketError error, const QString &reason)
+{
+    this->abort();
+    emit this->connectionFailed(error, reason);
+}
+
+void HostConnector::dropAttempts()
+{
+    for(auto * socket : this->attempts)
+        disposeSocket(socket);
+    this->attempts.clear();
+    this->attempt_start.clear();
+}
+
+QList<QHostAddress> HostConnector::interleave(const QList<QHostAddress> &addresses)
+{
+    QList<QHostAddress> ipv6;
+    QList<QHostAddress> ipv4;
+    for(auto const & address : addresses)
+    {
+        if(address.protocol() == QAbstractSocket::IPv6Protocol)
+            ipv6.append(address);
+        else
+            ipv4.append(address);
+    }
+
+    QList<QHostAddress> result;
+    while(not ipv6.isEmpty() or not ipv4.isEmpty())
+    {
+        if(not ipv6.isEmpty())
+            result.append(ipv6.takeFirst());
+        if(not ipv4.isEmpty())
+            result.append(ipv4.takeFirst());
+    }
+    return result;
+}
@@ -0,0 +1,100 @@
+#ifndef HOSTCONNECTOR_HPP
+#define HOSTCONNECTOR_HPP
+
+#include <QObject>
+#include <QAbstractSocket>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QHash>
+
+#include <functional>
+
+//! Connects to a host by racing connections to all of its addresses
+//! with staggered starts ("Happy Eyeballs", RFC 8305), so a broken
+//! address family doesn't stall the connection.
+class HostConnector : public QObject
+{
+    Q_OBJECT
+public:
+    //! Creates a new, unconnected socket for a connection attempt
+    using SocketFactory = std::function<QAbstractSocket * ()>;
+
+    //! Delay before the next address is tried (in ms), as recommended by RFC 8305
+    static constexpr int connection_attempt_delay = 250;
+
+    //! Time a closed connection may take to shut down gracefully (in ms)
+    static constexpr int close_timeout = 1500;
+
+    explicit HostConnector(QObject * parent = nullptr);
+
+    ~HostConnector() override;
+
+    //! Resolves `host` with the shared resolver and connects to `port`
+    //! on all of its addresses. Emits either `connected` or `connectionFailed`.
+    //! A pending connection is aborted.
+    void connectToHost(QString const & host, quint16 port, SocketFactory const & factory);
+
+    //! Aborts all pending connection attempts. No signals are emitted afterwards.
+    void abort();
+
+    bool isConnecting() const { return is_connecting; }
+
+    //! Returns the number of sockets created by connectors that weren't
+    //! deleted yet, including pending attempts and closing connections.
+    static int openSockets();
+
+    //! Disconnects `socket` from all receivers and deletes it safely,
+    //! even from within one of its own signals.
+    static void disposeSocket(QAbstractSocket * socket);
+
+    //! Disconnects `socket` from all receivers and shuts the connection
+    //! down in the background. The socket is aborted if the peer doesn't
+    //! close it within `close_timeout` and deleted afterwards.
+    //! Never blocks, so a new request can start right away.
+    static void closeSocket(QAbstractSocket * socket);
+
+signals:
+    //! The host name was resolved.
+    void hostFound();
+
+    //! A connection was established. The receiver takes ownership of `socket`.
+    void connected(QAbstractSocket * socket);
+
+    //! No address of the host could be connected.
+    void connectionFailed(QAbstractSocket::SocketError error, QString const & reason);
+
+private:
+    void startNextAttempt();
+
+    void on_attemptConnected(QAbstractSocket * socket);
+
+    void on_attemptFailed(QAbstractSocket * socket);
+
+    void fail(QAbstractSocket::SocketError error, QString const & reason);
+
+    void dropAttempts();
+
+    //! Orders the addresses by alternating families, starting with IPv6.
+    static QList<QHostAddress> interleave(QList<QHostAddress> const & addresses);
+
+private:
+    SocketFactory factory;
+    QString host;
+    quint16 port = 0;
+    QList<QHostAddress> pending_addresses;
+    QList<QAbstractSocket *> attempts;
+    //! Start time of each attempt, used to measure the round-trip time
+    QHash<QAbstractSocket *, qint64> attempt_start;
+    QElapsedTimer clock;
+    QTimer attempt_timer;
+    bool is_connecting = false;
+    quint64 generation = 0;
+
+    QAbstractSocket::SocketError last_error = QAbstractSocket::UnknownSocketError;
+    QString last_error_string;
+};
+
+#endif // HOSTCONNECTOR_HPP
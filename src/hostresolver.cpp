@@ -0,0 +1,151 @@
+#include "hostresolver.hpp"
+#include "kristall.hpp"
+
+#include <QDebug>
+
+HostResolver::HostResolver(QObject *parent) : QObject(parent)
+{
+
+}
+
+HostResolver::~HostResolver()
+{
+    for(auto it = lookup_hosts.begin(); it != lookup_hosts.end(); ++it)
+        QHostInfo::abortHostLookup(it.key());
+}
+
+void HostResolver::resolve(const QString &host, QObject *context, const Callback &callback)
+{
+    QHostAddress literal;
+    if(literal.setAddress(host)) {
+        QHostInfo info;
+        info.setHostName(host);
+        info.setAddresses(QList<QHostAddress> { literal });
+        callback(info);
+        return;
+    }
+
+    auto const key = normalize(host);
+
+    if(auto const * entry = findValid(key); entry != nullptr) {
+        this->hit_count += 1;
+
+        QHostInfo info;
+        info.setHostName(host);
+        info.setAddresses(entry->addresses);
+        callback(info);
+        return;
+    }
+
+    this->miss_count += 1;
+
+    startLookup(key);
+    this->lookups[key].waiters.append(Waiter { context, callback });
+}
+
+void HostResolver::prefetch(const QString &host)
+{
+    if(host.isEmpty() or kristall::globals().options.offline_mode)
+        return;
+
+    QHostAddress literal;
+    if(literal.setAddress(host))
+        return;
+
+    auto const key = normalize(host);
+    if(findValid(key) != nullptr or lookups.contains(key))
+        return;
+
+    this->prefetch_count += 1;
+    startLookup(key);
+}
+
+void HostResolver::clear()
+{
+    this->entries.clear();
+    this->hit_count = 0;
+    this->miss_count = 0;
+    this->prefetch_count = 0;
+}
+
+void HostResolver::on_lookupFinished(const QHostInfo &info)
+{
+    auto const key = lookup_hosts.take(info.lookupId());
+    if(key.isEmpty())
+        return;
+
+    Lookup lookup = lookups.take(key);
+
+    if(info.error() == QHostInfo::NoError and not info.addresses().isEmpty()) {
+        if(not this->entries.contains(key) and this->entries.size() >= max_entries)
+            this->makeRoom();
+
+        this->entries.insert(key, Entry {
+            info.addresses(),
+            QDateTime::currentDateTimeUtc().addSecs(default_ttl),
+        });
+    } else {
+        qDebug() << "failed to resolve" << key << info.errorString();
+    }
+
+    for(auto const & waiter : lookup.waiters)
+    {
+        if(waiter.context.isNull())
+            continue;
+        waiter.callback(info);
+    }
+}
+
+QString HostResolver::normalize(const QString &host)
+{
+    return host.toLower();
+}
+
+HostResolver::Entry const * HostResolver::findValid(const QString &key)
+{
+    auto it = this->entries.find(key);
+    if(it == this->entries.end())
+        return nullptr;
+
+    if(QDateTime::currentDateTimeUtc() >= it->expires) {
+        this->entries.erase(it);
+        return nullptr;
+    }
+
+    return &it.value();
+}
+
+void HostResolver::startLookup(const QString &key)
+{
+    if(lookups.contains(key))
+        return;
+
+    int id = QHostInfo::lookupHost(key, this, SLOT(on_lookupFinished(QHostInfo)));
+    this->lookups.insert(key, Lookup { id, QList<Waiter> { } });
+    this->lookup_hosts.insert(id, key);
+}
+
+void HostResolver::makeRoom()
+{
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    for(auto it = this->entries.begin(); it != this->entries.end(); )
+    {
+        if(now >= it->expires)
+            it = this->entries.erase(it);
+        else
+            ++it;
+    }
+
+    if(this->entries.size() < max_entries)
+        return;
+
+    auto first = this->entries.end();
+    for(auto it = this->entries.begin(); it != this->entries.end(); ++it)
+    {
+        if(first == this->entries.end() or it->expires < first->expires)
+            first = it;
+    }
+    if(first != this->entries.end())
+        this->entries.erase(first);
+}
@@ -0,0 +1,96 @@
+#ifndef HOSTRESOLVER_HPP
+#define HOSTRESOLVER_HPP
+
+#include <QObject>
+#include <QHostInfo>
+#include <QHostAddress>
+#include <QDateTime>
+#include <QPointer>
+#include <QHash>
+#include <QList>
+
+#include <functional>
+
+//! Process-wide cache for host name lookups, so all protocol
+//! handlers and tabs share the results of a single DNS query.
+class HostResolver : public QObject
+{
+    Q_OBJECT
+public:
+    using Callback = std::function<void(QHostInfo const & info)>;
+
+    //! Time a successful lookup is kept in the cache (in seconds).
+    //! QHostInfo doesn't expose the record TTL, so we use a fixed one.
+    static constexpr int default_ttl = 5 * 60;
+
+    //! Maximum number of cached hosts
+    static constexpr int max_entries = 256;
+
+    //! Maximum number of hosts prefetched for a single page
+    static constexpr int max_prefetch_count = 16;
+
+    explicit HostResolver(QObject * parent = nullptr);
+
+    ~HostResolver() override;
+
+    //! Resolves `host` and calls `callback` with the result. If the host
+    //! is an address literal or the cache holds a valid entry, `callback`
+    //! is invoked before this function returns.
+    //! The callback is dropped when `context` is destroyed first.
+    void resolve(QString const & host, QObject * context, Callback const & callback);
+
+    //! Starts a lookup for `host` if it isn't cached or already resolving.
+    void prefetch(QString const & host);
+
+    //! Removes all cached entries and resets the statistics.
+    void clear();
+
+    int size() const { return entries.size(); }
+
+    int hits() const { return hit_count; }
+    int misses() const { return miss_count; }
+    int prefetches() const { return prefetch_count; }
+
+private slots:
+    void on_lookupFinished(QHostInfo const & info);
+
+private:
+    struct Entry
+    {
+        QList<QHostAddress> addresses;
+        QDateTime expires;
+    };
+
+    struct Waiter
+    {
+        QPointer<QObject> context;
+        Callback callback;
+    };
+
+    struct Lookup
+    {
+        int id;
+        QList<Waiter> waiters;
+    };
+
+    static QString normalize(QString const & host);
+
+    //! Returns the cached entry for `host` or nullptr, dropping expired entries.
+    Entry const * findValid(QString const & key);
+
+    void startLookup(QString const & key);
+
+    //! Makes room for a new entry by dropping all expired entries
+    //! or, if none expired, the one that expires first.
+    void makeRoom();
+
+    QHash<QString, Entry> entries;
+    QHash<QString, Lookup> lookups;
+    QHash<int, QString> lookup_hosts;
+
+    int hit_count = 0;
+    int miss_count = 0;
+    int prefetch_count = 0;
+};
+
+#endif // HOSTRESOLVER_HPP
@@ -0,0 +1,117 @@
+#include "hosttimings.hpp"
+#include "kristall.hpp"
+
+#include <QObject>
+
+#include <algorithm>
+#include <cmath>
+
+void HostTimings::Estimate::add(double sample)
+{
+    if(not this->isValid()) {
+        this->smoothed = sample;
+        this->variation = sample / 2.0;
+    } else {
+        this->variation = 0.75 * this->variation + 0.25 * std::abs(this->smoothed - sample);
+        this->smoothed = 0.875 * this->smoothed + 0.125 * sample;
+    }
+}
+
+void HostTimings::recordRoundTrip(const QString &host, qint64 ms)
+{
+    this->entry(host).round_trip.add(double(ms));
+}
+
+void HostTimings::recordResponseTime(const QString &host, qint64 ms)
+{
+    this->entry(host).response.add(double(ms));
+}
+
+int HostTimings::timeout(const QString &host, Phase phase) const
+{
+    int const base = kristall::globals().options.network_timeout;
+
+    auto it = this->hosts.find(host.toLower());
+    if(it == this->hosts.end())
+        return base;
+
+    auto const clamp = [](double value) {
+        return int(std::clamp(value, double(min_timeout), double(max_timeout)));
+    };
+
+    Entry const & timings = *it;
+    switch(phase)
+    {
+    case HostLookup:
+        // Lookups are done by the resolver and don't depend on the host
+        return base;
+
+    case Connect:
+        if(timings.round_trip.isValid())
+            return clamp(3.0 * timings.round_trip.bound());
+        return base;
+
+    case TlsHandshake:
+        // A full handshake takes two round trips
+        if(timings.round_trip.isValid())
+            return clamp(4.0 * timings.round_trip.bound());
+        return base;
+
+    case Response:
+        // Servers may take a while to generate a page, so the
+        // timeout is only ever extended for slow hosts.
+        if(timings.response.isValid())
+            return clamp(std::max<double>(base, 3.0 * timings.response.bound()));
+        return base;
+
+    case Transfer:
+        if(timings.round_trip.isValid())
+            return clamp(std::max<double>(base, 4.0 * timings.round_trip.bound()));
+        return base;
+    }
+    return base;
+}
+
+int HostTimings::roundTripTime(const QString &host) const
+{
+    auto it = this->hosts.find(host.toLower());
+    if(it == this->hosts.end() or not it->round_trip.isValid())
+        return -1;
+    return int(it->round_trip.smoothed);
+}
+
+void HostTimings::clear()
+{
+    this->hosts.clear();
+    this->use_counter = 0;
+}
+
+QString HostTimings::phaseName(Phase phase)
+{
+    switch(phase)
+    {
+    case HostLookup: return QObject::tr("host lookup");
+    case Connect: return QObject::tr("connection");
+    case TlsHandshake: return QObject::tr("TLS handshake");
+    case Response: return QObject::tr("response");
+    case Transfer: return QObject::tr("transfer");
+    }
+    return QString { };
+}
+
+HostTimings::Entry &HostTimings::entry(const QString &host)
+{
+    auto const key = host.toLower();
+    if(not this->hosts.contains(key) and this->hosts.size() >= max_hosts)
+    {
+        // Forget the host that wasn't used for the longest time
+        auto oldest = std::min_element(this->hosts.begin(), this->hosts.end(), [](Entry const & a, Entry const & b) {
+            return a.last_used < b.last_used;
+        });
+        this->hosts.erase(oldest);
+    }
+
+    auto & result = this->hosts[key];
+    result.last_used = ++this->use_counter;
+    return result;
+}
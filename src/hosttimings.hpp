@@ -0,0 +1,79 @@
+#ifndef HOSTTIMINGS_HPP
+#define HOSTTIMINGS_HPP
+
+#include <QString>
+#include <QHash>
+
+//! Records round-trip and response times per host and derives the
+//! timeouts for each phase of a request from them, so requests to fast
+//! hosts fail fast while slow, known-good hosts are given more time.
+//! Hosts without history use the configured network timeout.
+class HostTimings
+{
+public:
+    enum Phase
+    {
+        HostLookup,   //!< Resolving the host name
+        Connect,      //!< Establishing the TCP connection
+        TlsHandshake, //!< Negotiating the TLS session
+        Response,     //!< Waiting for the first byte of the response
+        Transfer,     //!< Waiting for more data of the response body
+    };
+
+    //! Lower bound for adapted timeouts (in ms)
+    static constexpr int min_timeout = 1000;
+
+    //! Upper bound for adapted timeouts (in ms)
+    static constexpr int max_timeout = 60 * 1000;
+
+    //! Maximum number of hosts with recorded timings
+    static constexpr int max_hosts = 256;
+
+    //! Records the time it took to connect to `host`, which is about one round trip.
+    void recordRoundTrip(QString const & host, qint64 ms);
+
+    //! Records the time between sending a request to `host` and receiving the first byte.
+    void recordResponseTime(QString const & host, qint64 ms);
+
+    //! Returns the timeout for `phase` of a request to `host` in ms.
+    int timeout(QString const & host, Phase phase) const;
+
+    //! Returns the smoothed round-trip time to `host` in ms, or -1 if unknown.
+    int roundTripTime(QString const & host) const;
+
+    int size() const { return hosts.size(); }
+
+    void clear();
+
+    //! Returns a short description of `phase` for error messages.
+    static QString phaseName(Phase phase);
+
+private:
+    //! Smoothed estimation of a latency as described in RFC 6298
+    struct Estimate
+    {
+        double smoothed = -1.0;
+        double variation = 0.0;
+
+        bool isValid() const { return smoothed >= 0.0; }
+
+        void add(double sample);
+
+        //! Upper bound for the expected latency
+        double bound() const { return smoothed + 4.0 * variation; }
+    };
+
+    struct Entry
+    {
+        Estimate round_trip;
+        Estimate response;
+        quint64 last_used = 0;
+    };
+
+    Entry & entry(QString const & host);
+
+    QHash<QString, Entry> hosts;
+    quint64 use_counter = 0;
+};
+
+#endif // HOSTTIMINGS_HPP
@@ -12,6 +12,14 @@
 #include "protocolsetup.hpp"
 #include "documentstyle.hpp"
 #include "cachehandler.hpp"
+#include "sslsessioncache.hpp"
+#include "sslconfigcache.hpp"
+#include "hosttimings.hpp"
+#include "connectionpool.hpp"
+#include "redirectcache.hpp"
+#include "gophermirrors.hpp"
+#include "hostresolver.hpp"
+#include "networkservice.hpp"
 
 enum class Theme : int
 {
@@ -32,6 +40,8 @@ enum class RequestState : int
     Started = 1,
     HostFound = 2,
     Connected = 3,
+    //! The host asked us to slow down, the request is retried later
+    Deferred = 4,
 
     StartedWeb = 255,
 };
@@ -101,6 +111,22 @@ struct GenericSettings
     // 5 seconds network timeout
     int network_timeout = 5000;
 
+    // Responses larger than this are saved instead of displayed,
+    // except for images, audio and video (in MiB)
+    int spill_threshold = 8;
+
+    // Displayed responses larger than this are aborted, 0 is unlimited (in MiB)
+    int download_limit = 100;
+
+    // Opens Gemini connections to hosts that are likely visited next
+    bool enable_preconnect = false;
+
+    // Races gopher menu items against their alternate servers
+    bool gopher_mirror_racing = false;
+
+    // Serves all requests from the cache without accessing the network
+    bool offline_mode = false;
+
     // Additional toolbar items
     bool enable_home_btn = false,
          enable_newtab_btn = true,
@@ -112,6 +138,14 @@ struct GenericSettings
     int cache_threshold = 125;
     int cache_life = 60;
     bool cache_unlimited_life = true;
+    // Shows expired pages and refreshes them in the background
+    bool cache_revalidate = false;
+
+    // Disk cache for HTTP(S) responses in MiB, 0 disables it
+    int http_cache_limit = 50;
+
+    // Fetches hovered links into the cache
+    bool enable_link_prefetch = false;
 
     SessionRestoreBehaviour session_restore_behaviour = RestoreLastSession;
 
@@ -132,6 +166,14 @@ class MainWindow;
 /// ~/.cache/kristall/
 ///     ./offline-pages/${HOST}/${HASHED_URL}
 ///         : Contains "mime/type\r\n${BLOB}"
+///     ./downloads/download-${RANDOM}
+///         : Bodies of large responses while they are downloaded
+///     ./http/
+///         : Disk cache for HTTP(S) responses
+///     ./tls-sessions.ini
+///         : TLS session tickets for resuming connections
+///     ./redirects.ini
+///         : Permanent redirections that were seen before
 /// ~/.config/kristall/
 ///     ./themes/${THEME_ID}/theme.qss
 ///     ./styles/${STYLE_ID}.ini
@@ -157,6 +199,12 @@ namespace kristall
         //! Contains files per host
         QDir offline_pages;
 
+        //! Contains response bodies too large to be kept in memory
+        QDir downloads;
+
+        //! Contains the disk cache for HTTP(S) responses
+        QDir http_cache;
+
         //! Contains custom UI themes for kristall
         QDir themes;
 
@@ -179,6 +227,22 @@ namespace kristall
 
         CacheHandler cache;
 
+        SslSessionCache ssl_sessions;
+
+        SslConfigCache ssl_configs;
+
+        RedirectCache redirects;
+
+        GopherMirrors gopher_mirrors;
+
+        HostResolver resolver;
+
+        HostTimings timings;
+
+        ConnectionPool connections;
+
+        NetworkService network;
+
         Trust trust;
 
         Dirs dirs;
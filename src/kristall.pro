@@ -98,6 +98,7 @@ SOURCES += \
     ../lib/luis-l-gist/interactiveview.cpp \
     browsertab.cpp \
     certificatehelper.cpp \
+    connectionpool.cpp \
     cryptoidentity.cpp \
     dialogs/certificateiodialog.cpp \
     dialogs/certificatemanagementdialog.cpp \
@@ -107,6 +108,10 @@ SOURCES += \
     documentoutlinemodel.cpp \
     documentstyle.cpp \
     favouritecollection.cpp \
+    gophermirrors.cpp \
+    hostconnector.cpp \
+    hostresolver.cpp \
+    hosttimings.cpp \
     identitycollection.cpp \
     ioutil.cpp \
     main.cpp \
@@ -120,17 +125,26 @@ SOURCES += \
     widgets/kristalltextbrowser.cpp \
     widgets/mediaplayer.cpp \
     mimeparser.cpp \
+    networkservice.cpp \
+    networkstatistics.cpp \
     protocolhandler.cpp \
     protocols/abouthandler.cpp \
     protocols/filehandler.cpp \
     protocols/fingerclient.cpp \
     protocols/geminiclient.cpp \
+    protocols/geminiresponseparser.cpp \
     protocols/gopherclient.cpp \
+    protocols/offlinehandler.cpp \
     protocols/webclient.cpp \
     protocolsetup.cpp \
+    redirectcache.cpp \
     renderers/geminirenderer.cpp \
     renderers/gophermaprenderer.cpp \
     renderers/plaintextrenderer.cpp \
+    requesttimings.cpp \
+    responsebody.cpp \
+    sslconfigcache.cpp \
+    sslsessioncache.cpp \
     ssltrust.cpp \
     tabbrowsinghistory.cpp \
     trustedhost.cpp \
@@ -147,6 +161,7 @@ HEADERS += \
     ../lib/luis-l-gist/interactiveview.hpp \
     browsertab.hpp \
     certificatehelper.hpp \
+    connectionpool.hpp \
     cryptoidentity.hpp \
     dialogs/certificateiodialog.hpp \
     dialogs/certificatemanagementdialog.hpp \
@@ -156,6 +171,10 @@ HEADERS += \
     documentoutlinemodel.hpp \
     documentstyle.hpp \
     favouritecollection.hpp \
+    gophermirrors.hpp \
+    hostconnector.hpp \
+    hostresolver.hpp \
+    hosttimings.hpp \
     identitycollection.hpp \
     ioutil.hpp \
     kristall.hpp \
@@ -168,17 +187,26 @@ HEADERS += \
     widgets/kristalltextbrowser.hpp \
     widgets/mediaplayer.hpp \
     mimeparser.hpp \
+    networkservice.hpp \
+    networkstatistics.hpp \
     protocolhandler.hpp \
     protocols/abouthandler.hpp \
     protocols/filehandler.hpp \
     protocols/fingerclient.hpp \
     protocols/geminiclient.hpp \
+    protocols/geminiresponseparser.hpp \
     protocols/gopherclient.hpp \
+    protocols/offlinehandler.hpp \
     protocols/webclient.hpp \
     protocolsetup.hpp \
+    redirectcache.hpp \
     renderers/geminirenderer.hpp \
     renderers/gophermaprenderer.hpp \
     renderers/plaintextrenderer.hpp \
+    requesttimings.hpp \
+    responsebody.hpp \
+    sslconfigcache.hpp \
+    sslsessioncache.hpp \
     ssltrust.hpp \
     tabbrowsinghistory.hpp \
     trustedhost.hpp \
@@ -507,6 +507,13 @@ int main(int argc, char *argv[])
     kristall::globals().dirs.cache_root  = QDir { cache_root };
 
     kristall::globals().dirs.offline_pages = derive_dir(kristall::globals().dirs.cache_root, "offline-pages");
+    kristall::globals().dirs.downloads = derive_dir(kristall::globals().dirs.cache_root, "downloads");
+    kristall::globals().dirs.http_cache = derive_dir(kristall::globals().dirs.cache_root, "http");
+
+    // Downloads that weren't saved by a previous session are worthless now
+    for(auto const & name : kristall::globals().dirs.downloads.entryList(QStringList { "download-*" }, QDir::Files)) {
+        kristall::globals().dirs.downloads.remove(name);
+    }
     kristall::globals().dirs.themes = derive_dir(kristall::globals().dirs.config_root, "themes");
 
     kristall::globals().dirs.styles = derive_dir(kristall::globals().dirs.config_root, "styles");
@@ -679,6 +686,18 @@ int main(int argc, char *argv[])
 
     kristall::setTheme(kristall::globals().options.theme);
 
+    QSettings ssl_session_settings {
+        kristall::globals().dirs.cache_root.absoluteFilePath("tls-sessions.ini"),
+        QSettings::IniFormat
+    };
+    kristall::globals().ssl_sessions.load(ssl_session_settings);
+
+    QSettings redirect_settings {
+        kristall::globals().dirs.cache_root.absoluteFilePath("redirects.ini"),
+        QSettings::IniFormat
+    };
+    kristall::globals().redirects.load(redirect_settings);
+
     if(ipc_server != nullptr) {
         QObject::connect(ipc_server.get(), &QLocalServer::newConnection, [&ipc_server]() {
             auto * const socket = ipc_server->nextPendingConnection();
@@ -789,12 +808,25 @@ int main(int argc, char *argv[])
 
     int exit_code = app.exec();
 
+    kristall::globals().ssl_sessions.save(ssl_session_settings);
+    ssl_session_settings.sync();
+    // Session tickets allow resuming the sessions, so only the user may read them
+    QFile::setPermissions(ssl_session_settings.fileName(), QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    kristall::globals().redirects.save(redirect_settings);
+    redirect_settings.sync();
+
     return exit_code;
 }
 
 void GenericSettings::load(QSettings &settings)
 {
     network_timeout = settings.value("network_timeout", 5000).toInt();
+    spill_threshold = settings.value("spill_threshold", 8).toInt();
+    download_limit = settings.value("download_limit", 100).toInt();
+    enable_preconnect = settings.value("enable_preconnect", false).toBool();
+    gopher_mirror_racing = settings.value("gopher_mirror_racing", false).toBool();
+    offline_mode = settings.value("offline_mode", false).toBool();
     start_page = settings.value("start_page", "about:favourites").toString();
     search_engine = settings.value("search_engine", "gemini://geminispace.info/search?%1").toString();
 
@@ -866,6 +898,9 @@ void GenericSettings::load(QSettings &settings)
     cache_threshold = settings.value("cache_threshold", 125).toInt();
     cache_life = settings.value("cache_life", 15).toInt();
     cache_unlimited_life = settings.value("cache_unlimited_life", true).toBool();
+    cache_revalidate = settings.value("cache_revalidate", false).toBool();
+    http_cache_limit = settings.value("http_cache_limit", 50).toInt();
+    enable_link_prefetch = settings.value("enable_link_prefetch", false).toBool();
 
     session_restore_behaviour = SessionRestoreBehaviour(settings.value("session_restore_behaviour", int(session_restore_behaviour)).toInt());
 }
@@ -916,6 +951,11 @@ void GenericSettings::save(QSettings &settings) const
     settings.setValue("max_redirections", max_redirections);
     settings.setValue("redirection_policy", int(redirection_policy));
     settings.setValue("network_timeout", network_timeout);
+    settings.setValue("spill_threshold", spill_threshold);
+    settings.setValue("download_limit", download_limit);
+    settings.setValue("enable_preconnect", enable_preconnect);
+    settings.setValue("gopher_mirror_racing", gopher_mirror_racing);
+    settings.setValue("offline_mode", offline_mode);
     settings.setValue("enable_home_btn", enable_home_btn);
     settings.setValue("enable_newtab_btn", enable_newtab_btn);
     settings.setValue("enable_root_btn", enable_root_btn);
@@ -925,6 +965,9 @@ void GenericSettings::save(QSettings &settings) const
     settings.setValue("cache_threshold", cache_threshold);
     settings.setValue("cache_life", cache_life);
     settings.setValue("cache_unlimited_life", cache_unlimited_life);
+    settings.setValue("cache_revalidate", cache_revalidate);
+    settings.setValue("http_cache_limit", http_cache_limit);
+    settings.setValue("enable_link_prefetch", enable_link_prefetch);
 
     if (kristall::EMOJIS_SUPPORTED)
     {
@@ -941,6 +984,11 @@ void kristall::applySettings()
     kristall::setTheme(kristall::globals().options.theme);
     kristall::setUiDensity(kristall::globals().options.ui_density, false);
 
+    kristall::globals().network.applySettings();
+
+    // Pooled connections were opened with the previous trust settings
+    kristall::globals().connections.clear();
+
     forAllAppWindows([](MainWindow * window)
     {
         window->applySettings();
@@ -63,6 +63,11 @@ MainWindow::MainWindow(QApplication * app, QWidget *parent) :
         }
     });
 
+    // Another window may have changed the offline mode
+    connect(this->ui->menuFile, &QMenu::aboutToShow, [this]() {
+        ui->actionWork_offline->setChecked(kristall::globals().options.offline_mode);
+    });
+
     connect(this->ui->menuView, &QMenu::aboutToShow, [this]() {
         for(QAction * act : this->ui->menuView->actions())
         {
@@ -239,6 +244,17 @@ void MainWindow::setRequestState(RequestState state)
         this->request_status = tr("Downloading...");
     } break;
 
+    case RequestState::Deferred:
+    {
+        QDateTime retry_time;
+        if(BrowserTab * tab = this->curTab(); tab != nullptr)
+            retry_time = tab->retry_time;
+        if(retry_time.isValid())
+            this->request_status = tr("Server asked to slow down, retrying at %1...").arg(retry_time.toLocalTime().time().toString("HH:mm:ss"));
+        else
+            this->request_status = tr("Server asked to slow down, waiting...");
+    } break;
+
     default:
     {
         this->request_status = "";
@@ -570,16 +586,38 @@ void MainWindow::on_actionAbout_Qt_triggered()
 
 void MainWindow::setFileStatus(const DocumentStats &stats)
 {
-    if(stats.isValid()) {
+    if(stats.is_in_progress) {
+        if(stats.expected_size > 0)
+            this->file_size->setText(QString(tr("%1 of %2")).arg(IoUtil::size_human(stats.file_size), IoUtil::size_human(stats.expected_size)));
+        else
+            this->file_size->setText(IoUtil::size_human(stats.file_size));
+        this->file_cached->setText("");
+        this->file_mime->setText("");
+
+        QString rate = QString(tr("%1/s")).arg(IoUtil::size_human(stats.throughput));
+        if(stats.eta >= 0)
+            rate += QString(tr(", %1 s left")).arg((stats.eta + 999) / 1000);
+        this->load_time->setText(rate);
+        this->load_time->setToolTip("");
+    } else if(stats.isValid()) {
         this->file_size->setText(IoUtil::size_human(stats.file_size));
         this->file_cached->setText(stats.loaded_from_cache ? tr("(cached)") : "");
         this->file_mime->setText(stats.mime_type.toString(false));
         this->load_time->setText(QString(tr("%1 ms")).arg(stats.loading_time));
+
+        QStringList details;
+        if(stats.throughput > 0)
+            details << QString(tr("%1/s on average")).arg(IoUtil::size_human(stats.throughput));
+        if(stats.timings.isValid())
+            details << stats.timings.toString();
+        details << QString(tr("Rendered in %1 ms")).arg(stats.render_time);
+        this->load_time->setToolTip(details.join("\n"));
     } else {
         this->file_size->setText("");
         this->file_cached->setText("");
         this->file_mime->setText("");
         this->load_time->setText("");
+        this->load_time->setToolTip("");
     }
 }
 
@@ -809,6 +847,25 @@ void MainWindow::on_actionShow_document_source_triggered()
     this->viewPageSource();
 }
 
+void MainWindow::on_actionShow_request_timings_triggered()
+{
+    BrowserTab * tab = this->curTab();
+    if(tab != nullptr) {
+        tab->openTimingView();
+    }
+}
+
+void MainWindow::on_actionWork_offline_triggered(bool checked)
+{
+    kristall::globals().options.offline_mode = checked;
+
+    // Warm connections must not be used while offline
+    if(checked)
+        kristall::globals().connections.clear();
+
+    kristall::saveSettings();
+}
+
 void MainWindow::on_actionNew_window_triggered()
 {
     kristall::openNewWindow(false);
@@ -107,6 +107,10 @@ private slots:
 
     void on_actionShow_document_source_triggered();
 
+    void on_actionShow_request_timings_triggered();
+
+    void on_actionWork_offline_triggered(bool checked);
+
     void on_actionNew_window_triggered();
 
     void on_actionClose_Window_triggered();
@@ -0,0 +1,727 @@
+#include "networkservice.hpp"
+
+#include "protocols/geminiclient.hpp"
+#include "protocols/webclient.hpp"
+#include "protocols/gopherclient.hpp"
+#include "protocols/fingerclient.hpp"
+#include "protocols/abouthandler.hpp"
+#include "protocols/filehandler.hpp"
+#include "protocols/offlinehandler.hpp"
+
+#include "kristall.hpp"
+
+#include <QTimer>
+#include <QFile>
+#include <QNetworkRequest>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+//! A fetch executed by a protocol handler. Identical requests that are
+//! made while the fetch is in flight share the job.
+struct NetworkJob
+{
+    QString key;
+    QUrl url;
+    ProtocolHandler::RequestOptions options;
+    CryptoIdentity identity;
+    NetworkRequest::Priority priority;
+
+    //! All handles that wait for the result of this job
+    QList<NetworkRequest*> requests;
+
+    ProtocolHandler * handler = nullptr;
+    //! Scheme of the handler pool `handler` belongs to
+    QString handler_scheme;
+
+    //! Last reported state, replayed to requests joining a running job
+    RequestState state = RequestState::None;
+    QSslCertificate host_certificate;
+
+    //! Time since the handler reported anything for this job
+    QElapsedTimer last_activity;
+
+    //! Number of times the host asked us to slow down
+    int backoff_retries = 0;
+
+    //! Phase timings of the handler, taken when the job is done
+    RequestTimings timings;
+};
+
+NetworkRequest::NetworkRequest(NetworkService *service, const QUrl &url, Priority priority) :
+    QObject(service),
+    service(service),
+    target_url(url),
+    request_priority(priority)
+{
+
+}
+
+bool NetworkRequest::isRunning() const
+{
+    return (this->job != nullptr) and (this->job->handler != nullptr);
+}
+
+void NetworkRequest::cancel()
+{
+    this->service->cancel(this);
+}
+
+NetworkService::NetworkService(QObject *parent) : QObject(parent)
+{
+    this->watchdog_timer.setInterval(watchdog_interval);
+    connect(&this->watchdog_timer, &QTimer::timeout, this, &NetworkService::on_watchdogTimeout);
+
+    this->backoff_timer.setSingleShot(true);
+    connect(&this->backoff_timer, &QTimer::timeout, this, &NetworkService::on_backoffTimeout);
+}
+
+NetworkService::~NetworkService()
+{
+    qDeleteAll(this->queue);
+    qDeleteAll(this->running);
+    this->queue.clear();
+    this->running.clear();
+    this->joinable_jobs.clear();
+}
+
+NetworkRequest *NetworkService::request(const QUrl &url, ProtocolHandler::RequestOptions options, const CryptoIdentity &identity, NetworkRequest::Priority priority)
+{
+    if(not idle_handlers.contains(url.scheme()))
+    {
+        auto handler = createHandler(url.scheme());
+        if(handler == nullptr)
+            return nullptr;
+        connectHandler(handler.get());
+        this->idle_handlers[url.scheme()].append(handler.get());
+        this->handlers.emplace_back(std::move(handler));
+    }
+
+    auto * request = new NetworkRequest(this, url, priority);
+
+    auto const key = jobKey(url, options, identity);
+    if(auto * job = this->joinable_jobs.value(key, nullptr); job != nullptr)
+    {
+        request->job = job;
+        job->requests.append(request);
+        this->coalesced_count += 1;
+
+        // A queued prefetch is promoted when the user requests the same page
+        if(priority == NetworkRequest::Foreground and job->priority == NetworkRequest::Background and job->handler == nullptr) {
+            job->priority = NetworkRequest::Foreground;
+            this->queue.removeOne(job);
+            auto it = std::find_if(queue.begin(), queue.end(), [](NetworkJob * other) {
+                return other->priority == NetworkRequest::Background;
+            });
+            this->queue.insert(it, job);
+            this->scheduleLater();
+        }
+
+        // Tell the new request what it missed, after the caller connected to it
+        if(job->handler != nullptr or job->state == RequestState::Deferred) {
+            QTimer::singleShot(0, request, [request]() {
+                if(request->job == nullptr)
+                    return;
+                emit request->requestStateChange(request->job->state);
+                if(not request->job->host_certificate.isNull())
+                    emit request->hostCertificateLoaded(request->job->host_certificate);
+            });
+        }
+
+        return request;
+    }
+
+    auto * job = new NetworkJob;
+    job->key = key;
+    job->url = url;
+    job->options = options;
+    job->identity = identity;
+    job->priority = priority;
+    job->requests.append(request);
+    request->job = job;
+
+    this->joinable_jobs.insert(key, job);
+
+    this->enqueue(job);
+
+    this->scheduleLater();
+
+    return request;
+}
+
+std::unique_ptr<ProtocolHandler> NetworkService::createHandler(const QString &scheme)
+{
+    if(scheme == "gemini")
+        return std::make_unique<GeminiClient>();
+    if(scheme == "finger")
+        return std::make_unique<FingerClient>();
+    if(scheme == "gopher")
+        return std::make_unique<GopherClient>();
+    if(scheme == "http" or scheme == "https")
+        return std::make_unique<WebClient>();
+    if(scheme == "about")
+        return std::make_unique<AboutHandler>();
+    if(scheme == "file")
+        return std::make_unique<FileHandler>();
+    if(scheme == "kristall+cache")
+        return std::make_unique<OfflineHandler>();
+    return nullptr;
+}
+
+QString NetworkService::handlerScheme(const QUrl &url)
+{
+    // Web requests are answered from the disk cache by the web client itself
+    if(kristall::globals().options.offline_mode) {
+        auto const scheme = url.scheme();
+        if(scheme == "gemini" or scheme == "gopher" or scheme == "finger")
+            return "kristall+cache";
+    }
+    return url.scheme();
+}
+
+QString NetworkService::hostKey(const QUrl &url)
+{
+    return url.host().toLower();
+}
+
+QString NetworkService::jobKey(const QUrl &url, ProtocolHandler::RequestOptions options, const CryptoIdentity &identity)
+{
+    QString key = url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment);
+    key += QString("\n%1\n").arg(int(options));
+    if(identity.isValid())
+        key += QString::fromLatin1(identity.certificate.digest(QCryptographicHash::Sha256).toHex());
+    return key;
+}
+
+void NetworkService::cancel(NetworkRequest *request)
+{
+    if(request->is_finished)
+        return;
+
+    auto * job = request->job;
+    request->job = nullptr;
+    request->is_finished = true;
+    request->deleteLater();
+
+    if(job == nullptr)
+        return;
+
+    job->requests.removeOne(request);
+    if(job->requests.isEmpty())
+        this->cancelJob(job);
+}
+
+void NetworkService::cancelJob(NetworkJob *job)
+{
+    if(auto * handler = job->handler; handler != nullptr)
+    {
+        this->running.remove(handler);
+        if(auto const host = hostKey(job->url); not host.isEmpty())
+            this->running_per_host[host] -= 1;
+        if(job->priority == NetworkRequest::Background)
+            this->running_background -= 1;
+
+        job->handler = nullptr;
+        this->stats.recordRequest(job->url, handler->bytesReceived(), handler->bytesSent(), handler->timings());
+        this->releaseHandler(job->handler_scheme, handler);
+    }
+    else
+    {
+        this->queue.removeOne(job);
+    }
+
+    if(this->joinable_jobs.value(job->key) == job)
+        this->joinable_jobs.remove(job->key);
+
+    delete job;
+
+    this->scheduleLater();
+}
+
+void NetworkService::enqueue(NetworkJob *job)
+{
+    // Foreground requests overtake all queued background requests
+    if(job->priority == NetworkRequest::Foreground) {
+        auto it = std::find_if(queue.begin(), queue.end(), [](NetworkJob * other) {
+            return other->priority == NetworkRequest::Background;
+        });
+        this->queue.insert(it, job);
+    } else {
+        this->queue.append(job);
+    }
+}
+
+void NetworkService::schedule()
+{
+    this->is_schedule_pending = false;
+
+    // Requests that can't be started because of the limits keep
+    // their place in the queue, but don't block other requests.
+    for(int i = 0; i < queue.size(); )
+    {
+        auto * job = queue.at(i);
+        if(not canStart(job)) {
+            i += 1;
+            continue;
+        }
+        queue.removeAt(i);
+        this->start(job);
+    }
+}
+
+void NetworkService::scheduleLater()
+{
+    if(this->is_schedule_pending)
+        return;
+    this->is_schedule_pending = true;
+    QTimer::singleShot(0, this, &NetworkService::schedule);
+}
+
+bool NetworkService::canStart(const NetworkJob *job) const
+{
+    auto const host = hostKey(job->url);
+
+    // Only background requests are limited, so tabs showing
+    // the same host never have to wait for each other.
+    if(job->priority == NetworkRequest::Background)
+    {
+        if(running_background >= max_background_requests)
+            return false;
+        if(not host.isEmpty() and running_per_host.value(host, 0) >= max_requests_per_host)
+            return false;
+    }
+
+    // Cached pages don't put any load on the host
+    if(handlerScheme(job->url) == "kristall+cache")
+        return true;
+
+    if(auto it = backoff_until.find(host); it != backoff_until.end() and *it > QDateTime::currentDateTimeUtc())
+        return false;
+
+    return true;
+}
+
+void NetworkService::start(NetworkJob *job)
+{
+    job->handler_scheme = handlerScheme(job->url);
+    auto * handler = this->acquireHandler(job->handler_scheme);
+    assert(handler != nullptr);
+
+    if(job->identity.isValid()) {
+        if(not handler->enableClientCertificate(job->identity)) {
+            this->releaseHandler(job->handler_scheme, handler);
+            auto const scheme = job->url.scheme();
+            this->finishJob(job, [scheme](int, NetworkRequest * request) {
+                emit request->networkError(ProtocolHandler::InvalidClientCertificate, tr("Client certificates are not supported for %1-URLs.").arg(scheme));
+            });
+            return;
+        }
+    } else {
+        handler->disableClientCertificate();
+    }
+
+    job->handler = handler;
+    job->last_activity.start();
+    this->running.insert(handler, job);
+    if(not this->watchdog_timer.isActive())
+        this->watchdog_timer.start();
+    if(auto const host = hostKey(job->url); not host.isEmpty())
+        this->running_per_host[host] += 1;
+    if(job->priority == NetworkRequest::Background)
+        this->running_background += 1;
+
+    handler->resetTimings();
+    if(not handler->startRequest(job->url, job->options))
+    {
+        // The handler may already have finished the request with an error
+        if(auto * failed = this->takeJob(handler); failed != nullptr) {
+            auto const url = failed->url;
+            this->finishJob(failed, [url](int, NetworkRequest * request) {
+                emit request->networkError(ProtocolHandler::UnknownError, tr("Failed to execute request to %1").arg(url.toString()));
+            });
+        }
+    }
+}
+
+bool NetworkService::supportsClientCertificates(const QString &scheme)
+{
+    auto * handler = this->acquireHandler(scheme);
+    if(handler == nullptr)
+        return false;
+    bool const result = handler->supportsClientCertificates();
+    this->releaseHandler(scheme, handler);
+    return result;
+}
+
+ProtocolHandler *NetworkService::acquireHandler(const QString &scheme)
+{
+    auto & idle = this->idle_handlers[scheme];
+    if(not idle.isEmpty())
+        return idle.takeLast();
+
+    auto handler = createHandler(scheme);
+    if(handler == nullptr)
+        return nullptr;
+    connectHandler(handler.get());
+
+    auto * result = handler.get();
+    this->handlers.emplace_back(std::move(handler));
+    return result;
+}
+
+void NetworkService::connectHandler(ProtocolHandler *handler)
+{
+    // Signals are fanned out to all requests of the job. A receiver may
+    // cancel its request while handling a signal, so the list is copied.
+    auto const forEachRequest = [this, handler](auto const & emitter) {
+        auto * job = jobFor(handler);
+        if(job == nullptr)
+            return;
+        job->last_activity.restart();
+        auto const requests = job->requests;
+        for(auto * request : requests) {
+            if(request->job == job)
+                emitter(request);
+        }
+    };
+
+    connect(handler, &ProtocolHandler::requestProgress, this, [forEachRequest](qint64 transferred, qint64 total) {
+        forEachRequest([&](NetworkRequest * request) {
+            emit request->requestProgress(transferred, total);
+        });
+    });
+    connect(handler, &ProtocolHandler::responseStarted, this, [this, handler, forEachRequest](QString const & mime) {
+        // Requests joining now would miss the start of the body
+        if(auto * job = jobFor(handler); job != nullptr and this->joinable_jobs.value(job->key) == job)
+            this->joinable_jobs.remove(job->key);
+        forEachRequest([&](NetworkRequest * request) {
+            emit request->responseStarted(mime);
+        });
+    });
+    connect(handler, &ProtocolHandler::responseData, this, [forEachRequest](QByteArray const & chunk) {
+        forEachRequest([&](NetworkRequest * request) {
+            emit request->responseData(chunk);
+        });
+    });
+    connect(handler, &ProtocolHandler::requestStateChange, this, [this, handler, forEachRequest](RequestState state) {
+        auto * job = jobFor(handler);
+        if(job == nullptr)
+            return;
+        job->state = state;
+        forEachRequest([&](NetworkRequest * request) {
+            emit request->requestStateChange(state);
+        });
+
+        // Handlers report their final state right before the signal that
+        // finishes the request. If none follows, the job would keep its
+        // slot forever, so it is finished with an error instead.
+        if(state == RequestState::None) {
+            QTimer::singleShot(0, this, [this, handler, job]() {
+                if(jobFor(handler) != job)
+                    return;
+                if(auto * lost = takeJob(handler)) {
+                    this->finishJob(lost, [](int, NetworkRequest * request) {
+                        emit request->networkError(ProtocolHandler::UnknownError, tr("The request ended without a response."));
+                    });
+                }
+            });
+        }
+    });
+    connect(handler, &ProtocolHandler::hostCertificateLoaded, this, [this, handler, forEachRequest](QSslCertificate const & cert) {
+        if(auto * job = jobFor(handler))
+            job->host_certificate = cert;
+        forEachRequest([&](NetworkRequest * request) {
+            emit request->hostCertificateLoaded(cert);
+        });
+    });
+
+    // All following signals finish the request
+    connect(handler, &ProtocolHandler::requestComplete, this, [this, handler](QByteArray const & data, QString const & mime) {
+        if(auto * job = takeJob(handler)) {
+            this->finishJob(job, [&](int, NetworkRequest * request) {
+                emit request->requestComplete(data, mime);
+            });
+        }
+    });
+    connect(handler, &ProtocolHandler::requestCompleteFile, this, [this, handler](QString const & file_name, QString const & mime) {
+        auto * job = takeJob(handler);
+        if(job == nullptr) {
+            QFile::remove(file_name);
+            return;
+        }
+
+        // All receivers share the file, which is removed once they have seen it
+        this->finishJob(job, [&](int, NetworkRequest * request) {
+            emit request->requestCompleteFile(file_name, mime);
+        });
+        QFile::remove(file_name);
+    });
+    connect(handler, &ProtocolHandler::redirected, this, [this, handler](QUrl const & uri, bool is_permanent) {
+        if(auto * job = takeJob(handler)) {
+            this->finishJob(job, [&](int, NetworkRequest * request) {
+                emit request->redirected(uri, is_permanent);
+            });
+        }
+    });
+    connect(handler, &ProtocolHandler::inputRequired, this, [this, handler](QString const & user_query, bool is_sensitive) {
+        if(auto * job = takeJob(handler)) {
+            this->finishJob(job, [&](int, NetworkRequest * request) {
+                emit request->inputRequired(user_query, is_sensitive);
+            });
+        }
+    });
+    connect(handler, &ProtocolHandler::networkError, this, [this, handler](ProtocolHandler::NetworkError error, QString const & reason) {
+        auto * job = takeJob(handler);
+        if(job == nullptr)
+            return;
+
+        this->stats.recordFailure(job->url, error);
+
+        if(error == ProtocolHandler::SlowDown)
+        {
+            // The reason is the number of seconds the host wants us to wait
+            bool ok = false;
+            int seconds = reason.trimmed().toInt(&ok);
+            if(not ok or seconds <= 0)
+                seconds = default_backoff_delay;
+            this->startBackoff(hostKey(job->url), std::min(seconds, max_backoff_delay));
+
+            if(job->backoff_retries < max_backoff_retries) {
+                job->backoff_retries += 1;
+                this->deferJob(job);
+                return;
+            }
+        }
+
+        this->finishJob(job, [&](int, NetworkRequest * request) {
+            emit request->networkError(error, reason);
+        });
+    });
+    connect(handler, &ProtocolHandler::certificateRequired, this, [this, handler](QString const & info) {
+        if(auto * job = takeJob(handler)) {
+            this->finishJob(job, [&](int, NetworkRequest * request) {
+                emit request->certificateRequired(info);
+            });
+        }
+    });
+}
+
+QDateTime NetworkService::backoffUntil(const QUrl &url) const
+{
+    auto const until = this->backoff_until.value(hostKey(url));
+    if(until.isValid() and until > QDateTime::currentDateTimeUtc())
+        return until;
+    return QDateTime { };
+}
+
+void NetworkService::startBackoff(const QString &host, int seconds)
+{
+    if(host.isEmpty())
+        return;
+
+    auto const delay = 1000 * seconds;
+    auto const until = QDateTime::currentDateTimeUtc().addMSecs(delay);
+    if(until > this->backoff_until.value(host))
+        this->backoff_until.insert(host, until);
+
+    // The timer fires when the earliest backoff ends
+    if(not this->backoff_timer.isActive() or this->backoff_timer.remainingTime() > delay)
+        this->backoff_timer.start(delay);
+}
+
+void NetworkService::deferJob(NetworkJob *job)
+{
+    this->deferred_count += 1;
+
+    job->state = RequestState::Deferred;
+    this->enqueue(job);
+
+    for(auto * request : job->requests)
+        emit request->requestStateChange(RequestState::Deferred);
+}
+
+void NetworkService::on_backoffTimeout()
+{
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    qint64 next = std::numeric_limits<qint64>::max();
+    for(auto it = this->backoff_until.begin(); it != this->backoff_until.end(); )
+    {
+        if(*it <= now) {
+            it = this->backoff_until.erase(it);
+        } else {
+            next = std::min(next, now.msecsTo(*it));
+            ++it;
+        }
+    }
+    if(not this->backoff_until.isEmpty())
+        this->backoff_timer.start(int(next));
+
+    this->schedule();
+}
+
+NetworkJob *NetworkService::takeJob(ProtocolHandler *handler)
+{
+    auto * job = this->running.take(handler);
+    if(job == nullptr)
+        return nullptr;
+
+    if(auto const host = hostKey(job->url); not host.isEmpty())
+        this->running_per_host[host] -= 1;
+    if(job->priority == NetworkRequest::Background)
+        this->running_background -= 1;
+
+    job->handler = nullptr;
+    job->timings = handler->timings();
+    this->stats.recordRequest(job->url, handler->bytesReceived(), handler->bytesSent(), handler->timings());
+
+    this->releaseHandler(job->handler_scheme, handler);
+
+    return job;
+}
+
+void NetworkService::finishJob(NetworkJob *job, const std::function<void(int, NetworkRequest *)> &emitter)
+{
+    if(this->joinable_jobs.value(job->key) == job)
+        this->joinable_jobs.remove(job->key);
+
+    // All requests are finished before any signal is emitted, so
+    // receivers can't cancel or join the job while it is finishing.
+    auto const requests = job->requests;
+    for(auto * request : requests) {
+        request->job = nullptr;
+        request->is_finished = true;
+        request->request_timings = job->timings;
+        request->deleteLater();
+    }
+    delete job;
+
+    for(int i = 0; i < requests.size(); i++)
+    {
+        // The handler won't report its final state anymore
+        emit requests.at(i)->requestStateChange(RequestState::None);
+        emitter(i, requests.at(i));
+    }
+}
+
+void NetworkService::releaseHandler(const QString &scheme, ProtocolHandler *handler)
+{
+    // The handler may still be inside the signal emission that finished
+    // the request, so it is reset and reused from the event loop.
+    QTimer::singleShot(0, this, [this, scheme, handler]() {
+        handler->cancelRequest();
+
+        auto & idle = this->idle_handlers[scheme];
+        if(idle.size() < max_idle_handlers) {
+            idle.append(handler);
+        } else {
+            auto it = std::find_if(handlers.begin(), handlers.end(), [handler](std::unique_ptr<ProtocolHandler> const & ptr) {
+                return ptr.get() == handler;
+            });
+            assert(it != handlers.end());
+            it->release()->deleteLater();
+            handlers.erase(it);
+        }
+
+        this->schedule();
+    });
+}
+
+NetworkJob *NetworkService::jobFor(ProtocolHandler *handler) const
+{
+    return this->running.value(handler, nullptr);
+}
+
+void NetworkService::on_watchdogTimeout()
+{
+    // Handlers enforce their own phase timeouts, so this only
+    // catches requests that got stuck without reporting anything.
+    qint64 const limit = 2 * qint64(std::max(kristall::globals().options.network_timeout, HostTimings::max_timeout));
+
+    QList<ProtocolHandler*> stuck;
+    for(auto it = this->running.begin(); it != this->running.end(); it++)
+    {
+        if(it.value()->last_activity.hasExpired(limit))
+            stuck.append(it.key());
+    }
+
+    for(auto * handler : stuck)
+    {
+        if(auto * job = takeJob(handler)) {
+            qDebug() << "request to" << job->url << "didn't report any activity, giving up";
+            this->finishJob(job, [](int, NetworkRequest * request) {
+                emit request->networkError(ProtocolHandler::Timeout, tr("The server didn't respond in time."));
+            });
+        }
+    }
+
+    if(this->running.isEmpty())
+        this->watchdog_timer.stop();
+}
+
+QNetworkAccessManager &NetworkService::webAccessManager(const CryptoIdentity &identity)
+{
+    if(not identity.isValid())
+    {
+        if(this->web_manager == nullptr) {
+            this->web_manager = this->createWebAccessManager();
+            this->updateWebCache();
+        }
+        return *this->web_manager;
+    }
+
+    auto const digest = identity.certificate.digest(QCryptographicHash::Sha256);
+    auto * manager = this->identity_web_managers.value(digest, nullptr);
+    if(manager == nullptr) {
+        manager = this->createWebAccessManager();
+        this->identity_web_managers.insert(digest, manager);
+    }
+    return *manager;
+}
+
+QNetworkAccessManager *NetworkService::createWebAccessManager()
+{
+    auto * manager = new QNetworkAccessManager(this);
+    manager->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
+    return manager;
+}
+
+void NetworkService::applySettings()
+{
+    this->updateWebCache();
+}
+
+void NetworkService::updateWebCache()
+{
+    // Responses requested with a client certificate are never cached on disk
+    if(this->web_manager == nullptr)
+        return;
+
+    qint64 const limit = qint64(kristall::globals().options.http_cache_limit) * 1024 * 1024;
+    if(limit <= 0)
+    {
+        if(this->web_cache != nullptr) {
+            this->web_cache->clear();
+            // The manager deletes the previous cache
+            this->web_manager->setCache(nullptr);
+            this->web_cache = nullptr;
+        }
+        return;
+    }
+
+    if(this->web_cache == nullptr)
+    {
+        // QNetworkAccessManager revalidates cached responses with If-None-Match
+        // and If-Modified-Since and serves 304 responses from the cache.
+        this->web_cache = new QNetworkDiskCache();
+        this->web_cache->setCacheDirectory(kristall::globals().dirs.http_cache.absolutePath());
+        this->web_cache->setMaximumCacheSize(limit);
+        this->web_manager->setCache(this->web_cache);
+    }
+    else
+    {
+        this->web_cache->setMaximumCacheSize(limit);
+    }
+}
@@ -0,0 +1,258 @@
+#ifndef NETWORKSERVICE_HPP
+#define NETWORKSERVICE_HPP
+
+#include "protocolhandler.hpp"
+#include "networkstatistics.hpp"
+#include "cryptoidentity.hpp"
+
+#include <QObject>
+#include <QUrl>
+#include <QHash>
+#include <QDateTime>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QList>
+#include <QTimer>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class NetworkService;
+struct NetworkJob;
+
+//! A single request made through the `NetworkService`. The handle mirrors
+//! the signals of `ProtocolHandler` and is owned by the service, which
+//! deletes it after the request was finished or cancelled.
+//! Identical requests that are in flight at the same time share a single
+//! fetch, so each handle receives the same signals.
+class NetworkRequest : public QObject
+{
+    Q_OBJECT
+    friend class NetworkService;
+public:
+    enum Priority
+    {
+        //! The request was made by the user and is scheduled first
+        Foreground,
+        //! Sub-requests and prefetches, only run when there is spare capacity
+        Background,
+    };
+
+public:
+    QUrl const & url() const { return target_url; }
+
+    Priority priority() const { return request_priority; }
+
+    //! Returns true if the request was handed to a protocol handler.
+    bool isRunning() const;
+
+    //! Returns true after a terminal signal was emitted or the request was cancelled.
+    bool isFinished() const { return is_finished; }
+
+    //! Returns the phase timings of the request once it is finished.
+    RequestTimings const & timings() const { return request_timings; }
+
+    //! Aborts the request. No further signals are emitted after this.
+    //! The shared fetch is only aborted when no other request waits for it.
+    void cancel();
+
+signals:
+    void requestProgress(qint64 transferred, qint64 total);
+    void responseStarted(QString const & mime);
+    void responseData(QByteArray const & chunk);
+    void requestComplete(QByteArray const & data, QString const & mime);
+    //! The body is stored in `file_name`, which is shared by all coalesced
+    //! requests and removed after the signal, so receivers must copy it.
+    void requestCompleteFile(QString const & file_name, QString const & mime);
+    void requestStateChange(RequestState state);
+    void redirected(QUrl const & uri, bool is_permanent);
+    void inputRequired(QString const & user_query, bool is_sensitive);
+    void networkError(ProtocolHandler::NetworkError error, QString const & reason);
+    void certificateRequired(QString const & info);
+    void hostCertificateLoaded(QSslCertificate const & cert);
+
+private:
+    NetworkRequest(NetworkService * service, QUrl const & url, Priority priority);
+
+    NetworkService * service;
+    QUrl target_url;
+    Priority request_priority;
+
+    NetworkJob * job = nullptr;
+    bool is_finished = false;
+    RequestTimings request_timings;
+};
+
+//! Process-wide service that executes all network requests. Protocol
+//! handlers are pooled and shared between all tabs, requests are queued
+//! and started with respect to per-host limits and their priority.
+//! Requests for the same URL with the same options and identity are
+//! coalesced while in flight, so only a single fetch is made.
+class NetworkService : public QObject
+{
+    Q_OBJECT
+    friend class NetworkRequest;
+public:
+    //! Maximum number of concurrent requests to a single host before
+    //! background requests to it are held back
+    static constexpr int max_requests_per_host = 2;
+
+    //! Maximum number of concurrent background requests
+    static constexpr int max_background_requests = 4;
+
+    //! Maximum number of idle handlers kept per scheme
+    static constexpr int max_idle_handlers = 2;
+
+    //! Interval in which running jobs are checked for a lack of activity (in ms)
+    static constexpr int watchdog_interval = 1000;
+
+    //! Delay if a host asks us to slow down without a valid delay (in seconds)
+    static constexpr int default_backoff_delay = 5;
+
+    //! Upper bound for the delay a host can ask for (in seconds)
+    static constexpr int max_backoff_delay = 5 * 60;
+
+    //! Number of times a request is retried after its host asked us to slow down
+    static constexpr int max_backoff_retries = 3;
+
+    explicit NetworkService(QObject * parent = nullptr);
+
+    ~NetworkService() override;
+
+    //! Queues a request for `url`. The request is started from the event loop,
+    //! so the caller can connect to the returned handle first.
+    //! Returns nullptr if no protocol handler supports the scheme of `url`.
+    NetworkRequest * request(
+        QUrl const & url,
+        ProtocolHandler::RequestOptions options,
+        CryptoIdentity const & identity = CryptoIdentity(),
+        NetworkRequest::Priority priority = NetworkRequest::Foreground);
+
+    //! Number of requests waiting for a free slot
+    int queuedCount() const { return queue.size(); }
+
+    //! Number of requests currently handled by a protocol handler
+    int runningCount() const { return running.size(); }
+
+    //! Number of requests that were served by joining an identical request in flight
+    quint64 coalescedCount() const { return coalesced_count; }
+
+    //! Number of times a request was deferred because its host asked us to slow down
+    quint64 deferredCount() const { return deferred_count; }
+
+    //! Returns the time until which requests to the host of `url` are held
+    //! back, or an invalid time if the host didn't ask us to slow down.
+    QDateTime backoffUntil(QUrl const & url) const;
+
+    //! Number of hosts that requests are currently held back for
+    int backoffCount() const { return backoff_until.size(); }
+
+    //! Traffic and response time statistics of all requests made so far
+    NetworkStatistics const & statistics() const { return stats; }
+
+    //! Returns true if requests to `scheme` can use a client certificate.
+    bool supportsClientCertificates(QString const & scheme);
+
+    //! Returns the long-lived access manager used for HTTP(S) requests, which
+    //! keeps connections alive between requests. Requests with a client
+    //! certificate get a manager per identity, so pooled connections are
+    //! never shared between identities.
+    QNetworkAccessManager & webAccessManager(CryptoIdentity const & identity);
+
+    //! Applies changed options, e.g. the size of the HTTP disk cache.
+    void applySettings();
+
+private:
+    static std::unique_ptr<ProtocolHandler> createHandler(QString const & scheme);
+
+    //! Returns the scheme of the handler that serves `url`, which
+    //! is the cache for network requests while offline.
+    static QString handlerScheme(QUrl const & url);
+
+    static QString hostKey(QUrl const & url);
+
+    //! Returns the key under which identical requests are coalesced.
+    static QString jobKey(QUrl const & url, ProtocolHandler::RequestOptions options, CryptoIdentity const & identity);
+
+    void cancel(NetworkRequest * request);
+
+    //! Aborts `job` and removes it from the queue or its handler.
+    void cancelJob(NetworkJob * job);
+
+    //! Inserts `job` into the queue according to its priority.
+    void enqueue(NetworkJob * job);
+
+    //! Starts as many queued requests as the limits allow.
+    void schedule();
+
+    //! Deferred call of `schedule()`, merged if called multiple times.
+    void scheduleLater();
+
+    bool canStart(NetworkJob const * job) const;
+
+    void start(NetworkJob * job);
+
+    ProtocolHandler * acquireHandler(QString const & scheme);
+
+    void connectHandler(ProtocolHandler * handler);
+
+    //! Removes the job currently running on `handler` and returns
+    //! the handler to the pool. Returns nullptr if no job is running.
+    NetworkJob * takeJob(ProtocolHandler * handler);
+
+    //! Finishes all requests of `job`, deletes the job and then calls
+    //! `emitter` with the index and handle of each request.
+    void finishJob(NetworkJob * job, std::function<void(int, NetworkRequest *)> const & emitter);
+
+    void releaseHandler(QString const & scheme, ProtocolHandler * handler);
+
+    NetworkJob * jobFor(ProtocolHandler * handler) const;
+
+    //! Finishes running jobs whose handler didn't report anything for
+    //! much longer than any phase timeout allows. This is the fallback
+    //! for handlers that never emit a terminal signal.
+    void on_watchdogTimeout();
+
+    //! Holds back all requests to `host` for the given number of seconds.
+    void startBackoff(QString const & host, int seconds);
+
+    //! Queues `job` again to be retried when the backoff of its host ends.
+    void deferJob(NetworkJob * job);
+
+    void on_backoffTimeout();
+
+    QNetworkAccessManager * createWebAccessManager();
+
+    //! Attaches, resizes or removes the disk cache of the anonymous web manager.
+    void updateWebCache();
+
+private:
+    std::vector<std::unique_ptr<ProtocolHandler>> handlers;
+    QHash<QString, QList<ProtocolHandler*>> idle_handlers;
+    QHash<ProtocolHandler*, NetworkJob*> running;
+    QHash<QString, int> running_per_host;
+    QList<NetworkJob*> queue;
+    //! Jobs that new identical requests can still join
+    QHash<QString, NetworkJob*> joinable_jobs;
+    int running_background = 0;
+    bool is_schedule_pending = false;
+    QTimer watchdog_timer;
+    quint64 coalesced_count = 0;
+
+    //! Hosts that asked us to slow down and when requests may be sent again
+    QHash<QString, QDateTime> backoff_until;
+    QTimer backoff_timer;
+    quint64 deferred_count = 0;
+
+    NetworkStatistics stats;
+
+    QNetworkAccessManager * web_manager = nullptr;
+    //! Disk cache of `web_manager`, owned by the manager
+    QNetworkDiskCache * web_cache = nullptr;
+    //! Access managers for client certificate requests, by certificate digest
+    QHash<QByteArray, QNetworkAccessManager*> identity_web_managers;
+};
+
+#endif // NETWORKSERVICE_HPP
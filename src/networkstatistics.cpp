@@ -0,0 +1,99 @@
+#include "networkstatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+NetworkStatistics::Latency NetworkStatistics::HostStats::timeToFirstByte() const
+{
+    return summarize(this->first_byte_times);
+}
+
+void NetworkStatistics::recordRequest(const QUrl &url, qint64 bytes_received, qint64 bytes_sent, const RequestTimings &timings)
+{
+    auto const add = [&](Counters & counters) {
+        counters.requests += 1;
+        counters.bytes_received += bytes_received;
+        counters.bytes_sent += bytes_sent;
+    };
+
+    add(this->totals);
+    add(this->protocol_stats[url.scheme()]);
+
+    HostStats * stats = this->host(url);
+    if(stats != nullptr)
+        add(stats->counters);
+
+    if(timings.hasEvent(RequestTimings::FirstByte))
+    {
+        qint64 const first_byte = timings.at(RequestTimings::FirstByte);
+        addSample(this->first_byte_times, first_byte, max_samples);
+        if(stats != nullptr)
+            addSample(stats->first_byte_times, first_byte, max_host_samples);
+    }
+}
+
+void NetworkStatistics::recordFailure(const QUrl &url, ProtocolHandler::NetworkError error)
+{
+    this->totals.failures += 1;
+    this->protocol_stats[url.scheme()].failures += 1;
+    if(HostStats * stats = this->host(url); stats != nullptr)
+        stats->counters.failures += 1;
+    this->failure_counts[error] += 1;
+}
+
+void NetworkStatistics::clear()
+{
+    this->totals = Counters { };
+    this->first_byte_times.clear();
+    this->host_stats.clear();
+    this->protocol_stats.clear();
+    this->failure_counts.clear();
+    this->use_counter = 0;
+}
+
+NetworkStatistics::HostStats *NetworkStatistics::host(const QUrl &url)
+{
+    auto const key = url.host().toLower();
+    if(key.isEmpty())
+        return nullptr;
+
+    if(not this->host_stats.contains(key) and this->host_stats.size() >= max_hosts)
+    {
+        // Forget the host that wasn't used for the longest time
+        auto oldest = std::min_element(this->host_stats.begin(), this->host_stats.end(), [](HostStats const & a, HostStats const & b) {
+            return a.last_used < b.last_used;
+        });
+        this->host_stats.erase(oldest);
+    }
+
+    auto & result = this->host_stats[key];
+    result.last_used = ++this->use_counter;
+    return &result;
+}
+
+void NetworkStatistics::addSample(QVector<qint64> &samples, qint64 sample, int limit)
+{
+    if(samples.size() >= limit)
+        samples.removeFirst();
+    samples.append(sample);
+}
+
+NetworkStatistics::Latency NetworkStatistics::summarize(const QVector<qint64> &samples)
+{
+    Latency result;
+    result.samples = samples.size();
+    if(samples.isEmpty())
+        return result;
+
+    qint64 sum = 0;
+    for(qint64 sample : samples)
+        sum += sample;
+    result.mean = sum / samples.size();
+
+    QVector<qint64> sorted = samples;
+    int const index = std::min(int(sorted.size()) - 1, int(std::ceil(0.95 * sorted.size())) - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    result.p95 = sorted.at(index);
+
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef NETWORKSTATISTICS_HPP
+#define NETWORKSTATISTICS_HPP
+
+#include "protocolhandler.hpp"
+
+#include <QString>
+#include <QHash>
+#include <QMap>
+#include <QUrl>
+#include <QVector>
+
+//! Counts the traffic, requests, failures and response times of all
+//! requests made through the `NetworkService`, per host and per protocol.
+//! Shown on about:network to spot misbehaving hosts.
+class NetworkStatistics
+{
+public:
+    //! Maximum number of hosts with recorded statistics
+    static constexpr int max_hosts = 256;
+
+    //! Number of most recent time-to-first-byte samples that are kept
+    static constexpr int max_samples = 256;
+
+    //! Number of most recent time-to-first-byte samples kept per host
+    static constexpr int max_host_samples = 32;
+
+    struct Latency
+    {
+        int samples = 0;
+        qint64 mean = -1; // in ms
+        qint64 p95 = -1; // in ms
+    };
+
+    struct Counters
+    {
+        quint64 requests = 0;
+        quint64 failures = 0;
+        qint64 bytes_received = 0;
+        qint64 bytes_sent = 0;
+    };
+
+    struct HostStats
+    {
+        Counters counters;
+        QVector<qint64> first_byte_times;
+        quint64 last_used = 0;
+
+        Latency timeToFirstByte() const;
+    };
+
+    //! Records a request to `url` that has ended, whether it was
+    //! successful, failed or cancelled.
+    void recordRequest(QUrl const & url, qint64 bytes_received, qint64 bytes_sent, RequestTimings const & timings);
+
+    //! Records that the request to `url` failed with `error`.
+    void recordFailure(QUrl const & url, ProtocolHandler::NetworkError error);
+
+    Counters total() const { return totals; }
+
+    Latency timeToFirstByte() const { return summarize(first_byte_times); }
+
+    QHash<QString, HostStats> const & hosts() const { return host_stats; }
+
+    QMap<QString, Counters> const & protocols() const { return protocol_stats; }
+
+    QMap<ProtocolHandler::NetworkError, quint64> const & failures() const { return failure_counts; }
+
+    void clear();
+
+private:
+    //! Returns the statistics of the host of `url`, or nullptr for local URLs.
+    HostStats * host(QUrl const & url);
+
+    static void addSample(QVector<qint64> & samples, qint64 sample, int limit);
+
+    static Latency summarize(QVector<qint64> const & samples);
+
+private:
+    Counters totals;
+    QVector<qint64> first_byte_times;
+    QHash<QString, HostStats> host_stats;
+    QMap<QString, Counters> protocol_stats;
+    QMap<ProtocolHandler::NetworkError, quint64> failure_counts;
+    quint64 use_counter = 0;
+};
+
+#endif // NETWORKSTATISTICS_HPP
@@ -1,7 +1,25 @@
 #include "protocolhandler.hpp"
+#include "kristall.hpp"
 
 ProtocolHandler::ProtocolHandler(QObject *parent) : QObject(parent)
 {
+    this->phase_timer.setSingleShot(true);
+    connect(&this->phase_timer, &QTimer::timeout, this, &ProtocolHandler::on_phaseTimeout);
+
+    connect(this, &ProtocolHandler::responseStarted, this, [this]() {
+        this->recordTiming(RequestTimings::FirstBodyByte);
+    });
+    connect(this, &ProtocolHandler::requestComplete, this, [this]() {
+        this->recordTiming(RequestTimings::Complete);
+    });
+    connect(this, &ProtocolHandler::requestCompleteFile, this, [this]() {
+        this->recordTiming(RequestTimings::Complete);
+    });
+}
+
+bool ProtocolHandler::supportsClientCertificates() const
+{
+    return true;
 }
 
 bool ProtocolHandler::enableClientCertificate(const CryptoIdentity &ident)
@@ -43,3 +61,105 @@ void ProtocolHandler::emitNetworkError(QAbstractSocket::SocketError error_code,
     }
     emit this->networkError(network_error, textual_description);
 }
+
+void ProtocolHandler::startPhaseTimeout(HostTimings::Phase phase, const QString &host)
+{
+    this->current_phase = phase;
+    this->phase_host = host;
+    this->phase_clock.start();
+    this->phase_timer.start(kristall::globals().timings.timeout(host, phase));
+}
+
+void ProtocolHandler::resetTimings()
+{
+    this->request_timings.start();
+    this->bytes_received = 0;
+    this->bytes_sent = 0;
+}
+
+void ProtocolHandler::recordTiming(RequestTimings::Event event)
+{
+    this->request_timings.record(event);
+}
+
+void ProtocolHandler::reportRequestSent(qint64 bytes)
+{
+    this->bytes_sent += bytes;
+    this->recordTiming(RequestTimings::RequestSent);
+}
+
+void ProtocolHandler::reportDataReceived(qint64 bytes)
+{
+    this->bytes_received += bytes;
+    this->recordTiming(RequestTimings::FirstByte);
+
+    // The request may already be complete
+    if(not this->phase_timer.isActive())
+        return;
+
+    if(this->current_phase == HostTimings::Response) {
+        kristall::globals().timings.recordResponseTime(this->phase_host, this->phase_clock.elapsed());
+        this->startPhaseTimeout(HostTimings::Transfer, this->phase_host);
+    } else {
+        this->startPhaseTimeout(this->current_phase, this->phase_host);
+    }
+}
+
+void ProtocolHandler::stopPhaseTimeout()
+{
+    this->phase_timer.stop();
+}
+
+void ProtocolHandler::on_phaseTimeout()
+{
+    if(not this->isInProgress())
+        return;
+
+    NetworkError error = Timeout;
+    switch(this->current_phase)
+    {
+    case HostTimings::HostLookup: error = HostLookupTimeout; break;
+    case HostTimings::Connect: error = ConnectTimeout; break;
+    case HostTimings::TlsHandshake: error = TlsHandshakeTimeout; break;
+    case HostTimings::Response: error = ResponseTimeout; break;
+    case HostTimings::Transfer: error = TransferTimeout; break;
+    }
+
+    auto const reason = QString(tr("The %1 timed out after %2 ms."))
+        .arg(HostTimings::phaseName(this->current_phase))
+        .arg(this->phase_timer.interval());
+
+    // The error finishes the request, so the handler must not report anything else
+    emit this->networkError(error, reason);
+    this->cancelRequest();
+}
+
+QString ProtocolHandler::errorName(NetworkError error)
+{
+    switch(error)
+    {
+    case UnknownError: return "UnknownError";
+    case ProtocolViolation: return "ProtocolViolation";
+    case HostNotFound: return "HostNotFound";
+    case ConnectionRefused: return "ConnectionRefused";
+    case ResourceNotFound: return "ResourceNotFound";
+    case BadRequest: return "BadRequest";
+    case ProxyRequest: return "ProxyRequest";
+    case InternalServerError: return "InternalServerError";
+    case InvalidClientCertificate: return "InvalidClientCertificate";
+    case UntrustedHost: return "UntrustedHost";
+    case MistrustedHost: return "MistrustedHost";
+    case Unauthorized: return "Unauthorized";
+    case TlsFailure: return "TlsFailure";
+    case Timeout: return "Timeout";
+    case DownloadLimitExceeded: return "DownloadLimitExceeded";
+    case HostLookupTimeout: return "HostLookupTimeout";
+    case ConnectTimeout: return "ConnectTimeout";
+    case TlsHandshakeTimeout: return "TlsHandshakeTimeout";
+    case ResponseTimeout: return "ResponseTimeout";
+    case TransferTimeout: return "TransferTimeout";
+    case SlowDown: return "SlowDown";
+    case Offline: return "Offline";
+    }
+    return QString::number(int(error));
+}
@@ -2,9 +2,13 @@
 #define GENERICPROTOCOLCLIENT_HPP
 
 #include "cryptoidentity.hpp"
+#include "hosttimings.hpp"
+#include "requesttimings.hpp"
 
 #include <QObject>
 #include <QAbstractSocket>
+#include <QTimer>
+#include <QElapsedTimer>
 
 enum class RequestState : int;
 
@@ -27,6 +31,14 @@ public:
         Unauthorized, //!< The requested resource could not be accessed.
         TlsFailure, //!< Unspecified TLS failure
         Timeout, //!< The network connection timed out.
+        DownloadLimitExceeded, //!< The response is larger than the configured download limit
+        HostLookupTimeout, //!< The host name could not be resolved in time
+        ConnectTimeout, //!< The connection to the host could not be established in time
+        TlsHandshakeTimeout, //!< The TLS handshake did not complete in time
+        ResponseTimeout, //!< The server did not start its response in time
+        TransferTimeout, //!< The server stopped sending the response body
+        SlowDown, //!< The server is rate limiting us, the reason holds the seconds to wait
+        Offline, //!< Offline mode is enabled and the resource is not cached
     };
     enum RequestOptions {
         Default = 0,
@@ -41,17 +53,58 @@ public:
 
     virtual bool isInProgress() const = 0;
 
+    //! Aborts the current request without blocking. Open connections
+    //! are shut down in the background.
     virtual bool cancelRequest() = 0;
 
+    //! Returns false if `enableClientCertificate` would reject every identity.
+    virtual bool supportsClientCertificates() const;
+
     virtual bool enableClientCertificate(CryptoIdentity const & ident);
     virtual void disableClientCertificate();
+
+    //! Clears the timings of the previous request and starts the clock
+    //! for the next one. Must be called before `startRequest`.
+    void resetTimings();
+
+    //! Returns the phase timings of the current or last request.
+    RequestTimings const & timings() const {
+        return this->request_timings;
+    }
+
+    //! Returns the number of bytes received for the current or last request.
+    qint64 bytesReceived() const {
+        return this->bytes_received;
+    }
+
+    //! Returns the number of bytes sent for the current or last request.
+    qint64 bytesSent() const {
+        return this->bytes_sent;
+    }
+
+    //! Returns the name of `error` for diagnostics.
+    static QString errorName(NetworkError error);
 signals:
-    //! We successfully transferred some bytes from the server
-    void requestProgress(qint64 transferred);
+    //! We successfully transferred some bytes from the server.
+    //! `total` is the expected size of the body or -1 if unknown.
+    void requestProgress(qint64 transferred, qint64 total);
+
+    //! The server accepted the request and will now send a body of the given mime type.
+    //! This is followed by any number of `responseData` signals and a final `requestComplete`.
+    void responseStarted(QString const & mime);
+
+    //! A chunk of the response body was received. All chunks concatenated
+    //! are equal to the data passed to `requestComplete`.
+    void responseData(QByteArray const & chunk);
 
     //! The request completed with the given data and mime type
     void requestComplete(QByteArray const & data, QString const & mime);
 
+    //! The request completed, but the body was too large to be kept in memory
+    //! and is stored in the file `file_name`. The receiver owns the file.
+    //! No more `responseData` is emitted once the body is moved to the file.
+    void requestCompleteFile(QString const & file_name, QString const & mime);
+
     //! The state of the request has changed
     void requestStateChange(RequestState state);
 
@@ -71,6 +124,38 @@ signals:
     void hostCertificateLoaded(QSslCertificate const & cert);
 protected:
     void emitNetworkError(QAbstractSocket::SocketError error_code, QString const & textual_description);
+
+    //! Starts the timeout for `phase` of the request to `host`, replacing the
+    //! timeout of the previous phase. The duration adapts to the timings recorded
+    //! for `host`. When it expires, a phase-specific timeout error is emitted
+    //! and the request is cancelled.
+    void startPhaseTimeout(HostTimings::Phase phase, QString const & host);
+
+    //! Must be called when `bytes` of response data were received. Records the
+    //! response time after the first data and keeps the transfer timeout alive.
+    void reportDataReceived(qint64 bytes);
+
+    //! Must be called when the request was written. Records the time and
+    //! the size of the request.
+    void reportRequestSent(qint64 bytes);
+
+    void stopPhaseTimeout();
+
+    //! Records that the current request reached `event`.
+    void recordTiming(RequestTimings::Event event);
+
+private:
+    void on_phaseTimeout();
+
+private:
+    QTimer phase_timer;
+    QElapsedTimer phase_clock;
+    HostTimings::Phase current_phase = HostTimings::HostLookup;
+    QString phase_host;
+    RequestTimings request_timings;
+    qint64 bytes_received = 0;
+    qint64 bytes_sent = 0;
+
 };
 
 #endif // GENERICPROTOCOLCLIENT_HPP
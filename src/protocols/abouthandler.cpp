@@ -1,10 +1,122 @@
 #include "abouthandler.hpp"
 #include "kristall.hpp"
 #include "ioutil.hpp"
+#include "hostconnector.hpp"
 
 #include <QUrl>
 #include <QFile>
 
+#include <algorithm>
+
+static QString formatLatency(NetworkStatistics::Latency const & latency)
+{
+    if(latency.samples == 0)
+        return "-";
+    return QString("%1 / %2 ms").arg(latency.mean).arg(latency.p95);
+}
+
+static QString formatRate(int hits, int total)
+{
+    if(total <= 0)
+        return "-";
+    return QString("%1 %").arg(100 * hits / total);
+}
+
+static QByteArray renderNetworkStatistics()
+{
+    auto const & network = kristall::globals().network;
+    auto const & stats = network.statistics();
+    auto const total = stats.total();
+
+    QString document;
+    document += QObject::tr("# Network statistics\n");
+
+    document += QObject::tr(
+        "\nRequests:\n"
+        "* %1 requests, %2 failed\n"
+        "* %3 received, %4 sent\n"
+        "* Time to first byte: %5 (mean / p95 of the last %6 requests)\n"
+        "* %7 running, %8 queued\n"
+        "* %9 coalesced with identical requests\n")
+        .arg(QString::number(total.requests), QString::number(total.failures))
+        .arg(IoUtil::size_human(total.bytes_received), IoUtil::size_human(total.bytes_sent))
+        .arg(formatLatency(stats.timeToFirstByte()), QString::number(stats.timeToFirstByte().samples))
+        .arg(QString::number(network.runningCount()), QString::number(network.queuedCount()))
+        .arg(QString::number(network.coalescedCount()));
+
+    document += QObject::tr(
+        "* %1 deferred by hosts that asked to slow down, %2 hosts held back\n")
+        .arg(QString::number(network.deferredCount()), QString::number(network.backoffCount()));
+
+    auto const & sessions = kristall::globals().ssl_sessions;
+    auto const & connections = kristall::globals().connections;
+    int const lookups = sessions.hits() + sessions.misses();
+    document += QObject::tr(
+        "\nConnections:\n"
+        "* %1 open sockets\n"
+        "* TLS session resumption offered in %2 of %3 handshakes (%4)\n"
+        "* %5 pre-opened connections, %6 used, %7 waiting\n")
+        .arg(QString::number(HostConnector::openSockets()))
+        .arg(QString::number(sessions.hits()), QString::number(lookups), formatRate(sessions.hits(), lookups))
+        .arg(QString::number(connections.opened()), QString::number(connections.hits()), QString::number(connections.size()));
+
+    document += QObject::tr("\n## Protocols\n\n");
+    document += "```\n";
+    document += QString("%1 %2 %3 %4 %5\n")
+        .arg(QObject::tr("Protocol"), -10)
+        .arg(QObject::tr("Requests"), 10)
+        .arg(QObject::tr("Failures"), 10)
+        .arg(QObject::tr("Received"), 12)
+        .arg(QObject::tr("Sent"), 12);
+    for(auto it = stats.protocols().begin(); it != stats.protocols().end(); ++it)
+    {
+        document += QString("%1 %2 %3 %4 %5\n")
+            .arg(it.key(), -10)
+            .arg(it->requests, 10)
+            .arg(it->failures, 10)
+            .arg(IoUtil::size_human(it->bytes_received), 12)
+            .arg(IoUtil::size_human(it->bytes_sent), 12);
+    }
+    document += "```\n";
+
+    document += QObject::tr("\n## Failures\n\n");
+    if(stats.failures().isEmpty())
+        document += QObject::tr("No request failed yet.\n");
+    for(auto it = stats.failures().begin(); it != stats.failures().end(); ++it)
+        document += QString("* %1: %2\n").arg(ProtocolHandler::errorName(it.key())).arg(it.value());
+
+    // Hosts with the most traffic first
+    QStringList hosts = stats.hosts().keys();
+    std::sort(hosts.begin(), hosts.end(), [&](QString const & a, QString const & b) {
+        return stats.hosts()[a].counters.bytes_received > stats.hosts()[b].counters.bytes_received;
+    });
+
+    document += QObject::tr("\n## Hosts\n\n");
+    document += QObject::tr("Time to first byte is given as mean / p95 of the last %1 requests per host.\n\n").arg(NetworkStatistics::max_host_samples);
+    document += "```\n";
+    document += QString("%1 %2 %3 %4 %5 %6\n")
+        .arg(QObject::tr("Host"), -32)
+        .arg(QObject::tr("Requests"), 10)
+        .arg(QObject::tr("Failures"), 10)
+        .arg(QObject::tr("Received"), 12)
+        .arg(QObject::tr("Sent"), 12)
+        .arg(QObject::tr("First byte"), 20);
+    for(auto const & host : hosts)
+    {
+        auto const & host_stats = stats.hosts()[host];
+        document += QString("%1 %2 %3 %4 %5 %6\n")
+            .arg(host, -32)
+            .arg(host_stats.counters.requests, 10)
+            .arg(host_stats.counters.failures, 10)
+            .arg(IoUtil::size_human(host_stats.counters.bytes_received), 12)
+            .arg(IoUtil::size_human(host_stats.counters.bytes_sent), 12)
+            .arg(formatLatency(host_stats.timeToFirstByte()), 20);
+    }
+    document += "```\n";
+
+    return document.toUtf8();
+}
+
 AboutHandler::AboutHandler()
 {
 
@@ -68,8 +180,22 @@ bool AboutHandler::startRequest(const QUrl &url, ProtocolHandler::RequestOptions
             "* %2 pages in cache\n"))
             .arg(IoUtil::size_human(cache_usage), QString::number(cached_count)).toUtf8());
 
+        auto const & resolver = kristall::globals().resolver;
+        document.append(QString(
+            tr("\nDNS cache:\n"
+            "* %1 hosts in cache\n"
+            "* %2 hits\n"
+            "* %3 misses\n"
+            "* %4 prefetched lookups\n"))
+            .arg(QString::number(resolver.size()), QString::number(resolver.hits()),
+                 QString::number(resolver.misses()), QString::number(resolver.prefetches())).toUtf8());
+
         emit this->requestComplete(document, "text/gemini");
     }
+    else if (url.path() == "network")
+    {
+        emit this->requestComplete(renderNetworkStatistics(), "text/gemini");
+    }
     else
     {
         QFile file(QString(":/about/%1.gemini").arg(url.path()));
@@ -94,3 +220,8 @@ bool AboutHandler::cancelRequest()
 {
     return true;
 }
+
+bool AboutHandler::supportsClientCertificates() const
+{
+    return false;
+}
@@ -18,6 +18,8 @@ public:
     bool isInProgress() const override;
 
     bool cancelRequest() override;
+
+    bool supportsClientCertificates() const override;
 };
 
 #endif // ABOUTHANDLER_HPP
@@ -68,3 +68,8 @@ bool FileHandler::cancelRequest()
 {
     return true;
 }
+
+bool FileHandler::supportsClientCertificates() const
+{
+    return false;
+}
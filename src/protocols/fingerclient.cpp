@@ -2,27 +2,27 @@
 #include "ioutil.hpp"
 #include "kristall.hpp"
 
+#include <cassert>
+
 FingerClient::FingerClient() : ProtocolHandler(nullptr)
 {
-    connect(&socket, &QTcpSocket::connected, this, &FingerClient::on_connected);
-    connect(&socket, &QTcpSocket::readyRead, this, &FingerClient::on_readRead);
-    connect(&socket, &QTcpSocket::disconnected, this, &FingerClient::on_finished);
-
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
-    connect(&socket, &QTcpSocket::errorOccurred, this, &FingerClient::on_socketError);
-#else
-    connect(&socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &FingerClient::on_socketError);
-#endif
-
-    connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
+    connect(&connector, &HostConnector::hostFound, this, [this]() {
+        this->recordTiming(RequestTimings::HostFound);
+        this->startPhaseTimeout(HostTimings::Connect, this->requested_host);
         emit this->requestStateChange(RequestState::HostFound);
     });
+    connect(&connector, &HostConnector::connected, this, &FingerClient::on_socketConnected);
+    connect(&connector, &HostConnector::connectionFailed, this, [this](QAbstractSocket::SocketError error, QString const & reason) {
+        this->stopPhaseTimeout();
+        this->emitNetworkError(error, reason);
+    });
+
     emit this->requestStateChange(RequestState::None);
 }
 
 FingerClient::~FingerClient()
 {
-
+    HostConnector::disposeSocket(socket);
 }
 
 bool FingerClient::supportsScheme(const QString &scheme) const
@@ -41,47 +41,104 @@ bool FingerClient::startRequest(const QUrl &url, RequestOptions options)
         return false;
 
     this->requested_user = url.userName();
+    this->requested_host = url.host();
     this->was_cancelled = false;
-    socket.connectToHost(url.host(), url.port(79));
+    this->is_response_started = false;
+    if(socket != nullptr) {
+        HostConnector::closeSocket(socket);
+        socket = nullptr;
+    }
+    this->startPhaseTimeout(HostTimings::HostLookup, url.host());
+    connector.connectToHost(url.host(), url.port(79), []() -> QAbstractSocket * {
+        return new QTcpSocket();
+    });
 
     return true;
 }
 
 bool FingerClient::isInProgress() const
 {
-    return socket.isOpen();
+    return connector.isConnecting() or ((socket != nullptr) and socket->isOpen());
 }
 
 bool FingerClient::cancelRequest()
 {
     was_cancelled = true;
-    if (socket.state() != QTcpSocket::UnconnectedState)
+    this->stopPhaseTimeout();
+    connector.abort();
+    if (socket == nullptr)
     {
-        socket.disconnectFromHost();
-        this->socket.waitForDisconnected(500);
+        body.clear();
+        return true;
     }
-    socket.close();
+    // The connection is shut down in the background, so the
+    // next request doesn't have to wait for it.
+    HostConnector::closeSocket(socket);
+    socket = nullptr;
     body.clear();
+    emit this->requestStateChange(RequestState::None);
     return true;
 }
 
+bool FingerClient::supportsClientCertificates() const
+{
+    return false;
+}
+
+void FingerClient::on_socketConnected(QAbstractSocket *connected_socket)
+{
+    if(socket != nullptr)
+        HostConnector::disposeSocket(socket);
+    socket = qobject_cast<QTcpSocket*>(connected_socket);
+    assert(socket != nullptr);
+
+    connect(socket, &QTcpSocket::readyRead, this, &FingerClient::on_readRead);
+    connect(socket, &QTcpSocket::disconnected, this, &FingerClient::on_finished);
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(socket, &QTcpSocket::errorOccurred, this, &FingerClient::on_socketError);
+#else
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &FingerClient::on_socketError);
+#endif
+
+    this->recordTiming(RequestTimings::Connected);
+    this->on_connected();
+}
+
 void FingerClient::on_connected()
 {
     auto blob = (requested_user + "\r\n").toUtf8();
 
-    IoUtil::writeAll(socket, blob);
+    IoUtil::writeAll(*socket, blob);
+    this->reportRequestSent(blob.size());
+
+    this->startPhaseTimeout(HostTimings::Response, this->requested_host);
 
     emit this->requestStateChange(RequestState::Connected);
 }
 
 void FingerClient::on_readRead()
 {
-    body.append(socket.readAll());
-    emit this->requestProgress(body.size());
+    QByteArray chunk = socket->readAll();
+    body.append(chunk);
+
+    if(was_cancelled or chunk.isEmpty())
+        return;
+
+    this->reportDataReceived(chunk.size());
+
+    if(not is_response_started) {
+        is_response_started = true;
+        emit this->responseStarted("text/finger");
+    }
+    emit this->responseData(chunk);
+    emit this->requestProgress(body.size(), -1);
 }
 
 void FingerClient::on_finished()
 {
+    this->stopPhaseTimeout();
+
     if(not was_cancelled)
     {
         emit this->requestComplete(this->body, "text/finger");
@@ -96,8 +153,8 @@ void FingerClient::on_socketError(QAbstractSocket::SocketError error_code)
 {
     // Same as GopherClient::on_SocketError. See there for explanation
     if (error_code == QAbstractSocket::RemoteHostClosedError) {
-        socket.close();
+        socket->close();
         return;
     }
-    this->emitNetworkError(error_code, socket.errorString());
+    this->emitNetworkError(error_code, socket->errorString());
 }
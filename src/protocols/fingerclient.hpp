@@ -6,6 +6,7 @@
 #include <QUrl>
 
 #include "protocolhandler.hpp"
+#include "hostconnector.hpp"
 
 class FingerClient : public ProtocolHandler
 {
@@ -23,17 +24,24 @@ public:
 
     bool cancelRequest() override;
 
+    bool supportsClientCertificates() const override;
+
 private slots:
+    void on_socketConnected(QAbstractSocket * connected_socket);
     void on_connected();
     void on_readRead();
     void on_finished();
     void on_socketError(QTcpSocket::SocketError error_code);
 
 private:
-    QTcpSocket socket;
+    HostConnector connector;
+    //! The connection of the current request, owned by the client
+    QTcpSocket * socket = nullptr;
     QByteArray body;
     bool was_cancelled;
+    bool is_response_started;
     QString requested_user;
+    QString requested_host;
 };
 
 #endif // FINGERCLIENT_HPP
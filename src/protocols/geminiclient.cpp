@@ -6,36 +6,25 @@
 
 GeminiClient::GeminiClient() : ProtocolHandler(nullptr)
 {
-    connect(&socket, &QSslSocket::encrypted, this, &GeminiClient::socketEncrypted);
-    connect(&socket, &QSslSocket::readyRead, this, &GeminiClient::socketReadyRead);
-    connect(&socket, &QSslSocket::disconnected, this, &GeminiClient::socketDisconnected);
-//    connect(&socket, &QSslSocket::stateChanged, [](QSslSocket::SocketState state) {
-//        qDebug() << "Socket state changed to " << state;
-//    });
-    connect(&socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors), this, &GeminiClient::sslErrors);
-
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
-    connect(&socket, &QTcpSocket::errorOccurred, this, &GeminiClient::socketError);
-#else
-    connect(&socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &GeminiClient::socketError);
-#endif
-
-    // States
-    connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
+    connect(&connector, &HostConnector::hostFound, this, [this]() {
+        this->recordTiming(RequestTimings::HostFound);
+        this->startPhaseTimeout(HostTimings::Connect, this->target_url.host());
         emit this->requestStateChange(RequestState::HostFound);
     });
-    connect(&socket, &QAbstractSocket::connected, this, [this]() {
-        emit this->requestStateChange(RequestState::Connected);
-    });
-    connect(&socket, &QAbstractSocket::disconnected, this, [this]() {
-        emit this->requestStateChange(RequestState::None);
+    connect(&connector, &HostConnector::connected, this, &GeminiClient::socketConnected);
+    connect(&connector, &HostConnector::connectionFailed, this, [this](QAbstractSocket::SocketError error, QString const & reason) {
+        this->is_error_state = true;
+        this->stopPhaseTimeout();
+        this->emitNetworkError(error, reason);
     });
+
     emit this->requestStateChange(RequestState::None);
 }
 
 GeminiClient::~GeminiClient()
 {
     is_receiving_body = false;
+    HostConnector::disposeSocket(socket);
 }
 
 bool GeminiClient::supportsScheme(const QString &scheme) const
@@ -50,11 +39,10 @@ bool GeminiClient::startRequest(const QUrl &url, RequestOptions options)
 
     // qDebug() << "start request" << url;
 
-    if(socket.state() != QTcpSocket::UnconnectedState) {
-        socket.disconnectFromHost();
-        socket.close();
-        if(not socket.waitForDisconnected(1500))
-            return false;
+    connector.abort();
+    if(socket != nullptr) {
+        HostConnector::closeSocket(socket);
+        socket = nullptr;
     }
 
     emit this->requestStateChange(RequestState::Started);
@@ -63,76 +51,166 @@ bool GeminiClient::startRequest(const QUrl &url, RequestOptions options)
 
     this->options = options;
 
-    QSslConfiguration ssl_config = socket.sslConfiguration();
-    ssl_config.setProtocol(QSsl::TlsV1_2OrLater);
-    if(not kristall::globals().trust.gemini.enable_ca)
-        ssl_config.setCaCertificates(QList<QSslCertificate> { });
-    else
-        ssl_config.setCaCertificates(QSslConfiguration::systemCaCertificates());
-    socket.setSslConfiguration(ssl_config);
-
-    socket.connectToHostEncrypted(url.host(), url.port(1965));
+    ssl_config = createSslConfiguration(url, client_certificate, client_key);
 
-    this->buffer.clear();
+    this->parser.reset();
     this->body.clear();
+    this->body.reserve(initial_body_capacity);
     this->is_receiving_body = false;
-    this->suppress_socket_tls_error = true;
-
-    if(not socket.isOpen())
-        return false;
+    // Set once a more specific error than the one of the socket was reported
+    this->suppress_socket_tls_error = false;
 
     target_url = url;
     mime_type = "<invalid>";
 
+    if(this->useWarmConnection())
+        return true;
+
+    this->startPhaseTimeout(HostTimings::HostLookup, url.host());
+
+    // Connect to the resolved addresses, but keep the host name
+    // for SNI and certificate verification.
+    connector.connectToHost(url.host(), url.port(1965), [this]() -> QAbstractSocket * {
+        auto * ssl_socket = new QSslSocket();
+        ssl_socket->setSslConfiguration(this->ssl_config);
+        ssl_socket->setPeerVerifyName(this->target_url.host());
+        return ssl_socket;
+    });
+
     return true;
 }
 
 bool GeminiClient::isInProgress() const
 {
-    return (socket.state() != QTcpSocket::UnconnectedState);
+    return connector.isConnecting() or ((socket != nullptr) and (socket->state() != QTcpSocket::UnconnectedState));
 }
 
 bool GeminiClient::cancelRequest()
 {
     // qDebug() << "cancel request" << isInProgress();
-    if(isInProgress())
-    {
-        this->is_receiving_body = false;
-        this->socket.disconnectFromHost();
-        this->buffer.clear();
-        this->body.clear();
-        if (socket.state() != QTcpSocket::UnconnectedState)
-        {
-            socket.disconnectFromHost();
-        }
-        this->socket.waitForDisconnected(500);
-        this->socket.close();
-        bool success = not isInProgress();
-        // qDebug() << "cancel success" << success;
-        return success;
-    }
-    else
+    this->stopPhaseTimeout();
+    connector.abort();
+    this->is_receiving_body = false;
+    this->parser.reset();
+    this->body.clear();
+    if(socket != nullptr)
     {
-        return true;
+        // The connection is shut down in the background, so the
+        // next request doesn't have to wait for it.
+        HostConnector::closeSocket(socket);
+        socket = nullptr;
+        emit this->requestStateChange(RequestState::None);
     }
+    return true;
 }
 
 bool GeminiClient::enableClientCertificate(const CryptoIdentity &ident)
 {
-    this->socket.setLocalCertificate(ident.certificate);
-    this->socket.setPrivateKey(ident.private_key);
+    this->client_certificate = ident.certificate;
+    this->client_key = ident.private_key;
     return true;
 }
 
 void GeminiClient::disableClientCertificate()
 {
-    this->socket.setLocalCertificate(QSslCertificate{});
-    this->socket.setPrivateKey(QSslKey { });
+    this->client_certificate = QSslCertificate { };
+    this->client_key = QSslKey { };
+}
+
+QSslConfiguration GeminiClient::createSslConfiguration(const QUrl &url, const QSslCertificate &certificate, const QSslKey &key)
+{
+    // The prepared configuration is shared, setting the session
+    // ticket only copies it.
+    QSslConfiguration ssl_config = kristall::globals().ssl_configs.configuration(SslConfigCache::Gemini, certificate, key);
+
+    // Resume the last session with this host if possible. Sessions are only
+    // resumed for anonymous requests, so a session established with a client
+    // certificate can never be attributed to another identity.
+    if(certificate.isNull())
+        ssl_config.setSessionTicket(kristall::globals().ssl_sessions.find(url.host(), url.port(1965)));
+    else
+        ssl_config.setSessionTicket(QByteArray { });
+
+    return ssl_config;
+}
+
+void GeminiClient::socketConnected(QAbstractSocket *connected_socket)
+{
+    this->attachSocket(connected_socket);
+
+    this->recordTiming(RequestTimings::Connected);
+    emit this->requestStateChange(RequestState::Connected);
+
+    this->startPhaseTimeout(HostTimings::TlsHandshake, this->target_url.host());
+    socket->startClientEncryption();
+}
+
+bool GeminiClient::useWarmConnection()
+{
+    if(not client_certificate.isNull())
+        return false;
+
+    QList<QSslError> ssl_errors;
+    QSslSocket * warm_socket = kristall::globals().connections.take(target_url.host(), target_url.port(1965), ssl_errors);
+    if(warm_socket == nullptr)
+        return false;
+
+    this->attachSocket(warm_socket);
+
+    this->recordTiming(RequestTimings::HostFound);
+    this->recordTiming(RequestTimings::Connected);
+    emit this->requestStateChange(RequestState::HostFound);
+    emit this->requestStateChange(RequestState::Connected);
+
+    // The pool only ignored certificate errors, trust in the
+    // host is established now that it is actually visited.
+    if(not ssl_errors.isEmpty()) {
+        this->sslErrors(ssl_errors);
+        if(this->is_error_state) {
+            socket->close();
+            return true;
+        }
+    }
+
+    this->socketEncrypted();
+    return true;
+}
+
+void GeminiClient::attachSocket(QAbstractSocket *connected_socket)
+{
+    if(socket != nullptr)
+        HostConnector::disposeSocket(socket);
+    socket = qobject_cast<QSslSocket*>(connected_socket);
+    assert(socket != nullptr);
+
+    connect(socket, &QSslSocket::encrypted, this, &GeminiClient::socketEncrypted);
+    connect(socket, &QSslSocket::readyRead, this, &GeminiClient::socketReadyRead);
+    connect(socket, &QSslSocket::disconnected, this, &GeminiClient::socketDisconnected);
+    connect(socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors), this, &GeminiClient::sslErrors);
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    // TLS 1.3 sends session tickets after the handshake is done
+    connect(socket, &QSslSocket::newSessionTicketReceived, this, &GeminiClient::storeSessionTicket);
+#endif
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(socket, &QTcpSocket::errorOccurred, this, &GeminiClient::socketError);
+#else
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &GeminiClient::socketError);
+#endif
+
+    connect(socket, &QAbstractSocket::disconnected, this, [this]() {
+        emit this->requestStateChange(RequestState::None);
+    });
 }
 
 void GeminiClient::socketEncrypted()
 {
-    emit this->hostCertificateLoaded(this->socket.peerCertificate());
+    this->recordTiming(RequestTimings::TlsEstablished);
+
+    emit this->hostCertificateLoaded(this->socket->peerCertificate());
+
+    this->storeSessionTicket();
 
     QString request = target_url.toString(QUrl::FormattingOptions(QUrl::FullyEncoded)) + "\r\n";
 
@@ -140,193 +218,223 @@ void GeminiClient::socketEncrypted()
 
     qint64 offset = 0;
     while(offset < request_bytes.size()) {
-        auto const len = socket.write(request_bytes.constData() + offset, request_bytes.size() - offset);
+        auto const len = socket->write(request_bytes.constData() + offset, request_bytes.size() - offset);
         if(len <= 0)
         {
-            socket.close();
+            socket->close();
             return;
         }
         offset += len;
     }
+
+    this->reportRequestSent(request_bytes.size());
+    this->startPhaseTimeout(HostTimings::Response, this->target_url.host());
+}
+
+void GeminiClient::storeSessionTicket()
+{
+    if(not socket->localCertificate().isNull())
+        return;
+
+    auto const ssl_config = socket->sslConfiguration();
+    kristall::globals().ssl_sessions.store(
+        target_url.host(),
+        target_url.port(1965),
+        ssl_config.sessionTicket(),
+        ssl_config.sessionTicketLifeTimeHint());
 }
 
 void GeminiClient::socketReadyRead()
 {
     if(this->is_error_state) // don't do any further
         return;
-    QByteArray response = socket.readAll();
+
+    this->reportDataReceived(socket->bytesAvailable());
 
     if(is_receiving_body)
     {
-        body.append(response);
-        emit this->requestProgress(body.size());
+        this->receiveBody();
+        return;
     }
-    else
+
+    QByteArray const response = socket->readAll();
+
+    qint64 header_size = 0;
+    switch(parser.feed(response.constData(), response.size(), header_size))
     {
-        for(int i = 0; i < response.size(); i++)
+    case GeminiResponseParser::NeedMoreData:
+        return;
+
+    case GeminiResponseParser::Error:
+        socket->close();
+        qDebug() << parser.meta();
+        emit networkError(ProtocolViolation, parser.errorString());
+        return;
+
+    case GeminiResponseParser::HeaderComplete:
+        break;
+    }
+
+    // Whatever follows the header is already part of the body
+    if(not body.append(response.constData() + header_size, response.size() - header_size)) {
+        this->failBody();
+        return;
+    }
+
+    QString meta = QString::fromUtf8(parser.meta());
+
+    int primary_code = parser.primaryCode();
+    int secondary_code = parser.secondaryCode();
+
+    qDebug() << primary_code << secondary_code << meta;
+
+    // We don't need to receive any data after that.
+    if(primary_code != 2) {
+        this->stopPhaseTimeout();
+        socket->close();
+    }
+
+    switch(primary_code)
+    {
+    case 1: // requesting input
+        switch (secondary_code) {
+            case 1:
+            emit inputRequired(meta, true);
+            break;
+            case 0:
+            default:
+            emit inputRequired(meta, false);
+        }
+        return;
+
+    case 2: // success
+        is_receiving_body = true;
+        mime_type = meta;
+        body.setMimeType(MimeParser::parse(mime_type));
+        emit this->responseStarted(mime_type);
+        // The first chunk of the body may have arrived together with the header
+        if(not body.isEmpty())
+            emit this->responseData(body.data());
+        return;
+
+    case 3: { // redirect
+        QUrl new_url(meta);
+        if(new_url.isValid()) {
+            if(new_url.isRelative())
+                new_url =  target_url.resolved(new_url);
+            assert(not new_url.isRelative());
+
+            emit redirected(new_url, (secondary_code == 1));
+        }
+        else {
+            emit networkError(ProtocolViolation, QObject::tr("Invalid URL for redirection!"));
+        }
+        return;
+    }
+
+    case 4: { // temporary failure
+        NetworkError type = UnknownError;
+        switch(secondary_code)
         {
-            if(response[i] == '\n') {
-                buffer.append(response.data(), i);
-                body.append(response.data() + i + 1, response.size() - i - 1);
-
-                // "XY " <META> <CR> <LF>
-                if(buffer.size() < 4) { // we allow an empty <META>
-                    socket.close();
-                    qDebug() << buffer;
-                    emit networkError(ProtocolViolation, QObject::tr("Line is too short for valid protocol"));
-                    return;
-                }
-                if(buffer.size() >= 1200)
-                {
-                    emit networkError(ProtocolViolation, QObject::tr("response too large!"));
-                    socket.close();
-                }
-                if(buffer[buffer.size() - 1] != '\r') {
-                    socket.close();
-                    qDebug() << buffer;
-                    emit networkError(ProtocolViolation, QObject::tr("Line does not end with <CR> <LF>"));
-                    return;
-                }
-                if(not isdigit(buffer[0])) {
-                    socket.close();
-                    qDebug() << buffer;
-                    emit networkError(ProtocolViolation, QObject::tr("First character is not a digit."));
-                    return;
-                }
-                if(not isdigit(buffer[1])) {
-                    socket.close();
-                    qDebug() << buffer;
-                    emit networkError(ProtocolViolation, QObject::tr("Second character is not a digit."));
-                    return;
-                }
-                // TODO: Implement stricter version
-                // if(buffer[2] != ' ') {
-                if(not isspace(buffer[2])) {
-                    socket.close();
-                    qDebug() << buffer;
-                    emit networkError(ProtocolViolation, QObject::tr("Third character is not a space."));
-                    return;
-                }
-
-                QString meta = QString::fromUtf8(buffer.data() + 3, buffer.size() - 4);
-
-                int primary_code = buffer[0] - '0';
-                int secondary_code = buffer[1] - '0';
-
-                qDebug() << primary_code << secondary_code << meta;
-
-                // We don't need to receive any data after that.
-                if(primary_code != 2)
-                    socket.close();
-
-                switch(primary_code)
-                {
-                case 1: // requesting input
-                    switch (secondary_code) {
-                        case 1:
-                        emit inputRequired(meta, true);
-                        break;
-                        case 0:
-                        default:
-                        emit inputRequired(meta, false);
-                    }
-                    return;
-
-                case 2: // success
-                    is_receiving_body = true;
-                    mime_type = meta;
-                    return;
-
-                case 3: { // redirect
-                    QUrl new_url(meta);
-                    if(new_url.isValid()) {
-                        if(new_url.isRelative())
-                            new_url =  target_url.resolved(new_url);
-                        assert(not new_url.isRelative());
-
-                        emit redirected(new_url, (secondary_code == 1));
-                    }
-                    else {
-                        emit networkError(ProtocolViolation, QObject::tr("Invalid URL for redirection!"));
-                    }
-                    return;
-                }
-
-                case 4: { // temporary failure
-                    NetworkError type = UnknownError;
-                    switch(secondary_code)
-                    {
-                    case 1: type = InternalServerError; break;
-                    case 2: type = InternalServerError; break;
-                    case 3: type = InternalServerError; break;
-                    case 4: type = UnknownError; break;
-                    }
-                    emit networkError(type, meta);
-                    return;
-                }
-
-                case 5: { // permanent failure
-                    NetworkError type = UnknownError;
-                    switch(secondary_code)
-                    {
-                    case 1: type = ResourceNotFound; break;
-                    case 2: type = ResourceNotFound; break;
-                    case 3: type = ProxyRequest; break;
-                    case 9: type = BadRequest; break;
-                    }
-                    emit networkError(type, meta);
-                    return;
-                }
-
-                case 6: // client certificate required
-                    switch(secondary_code)
-                    {
-                    case 0:
-                        emit certificateRequired(meta);
-                        return;
-
-                    case 1:
-                        emit networkError(Unauthorized, meta);
-                        return;
-
-                    default:
-                    case 2:
-                        emit networkError(InvalidClientCertificate, meta);
-                        return;
-                    }
-                    return;
-
-                default:
-                    emit networkError(ProtocolViolation, QObject::tr("Unspecified status code used!"));
-                    return;
-                }
-
-                assert(false and "unreachable");
-            }
+        case 1: type = InternalServerError; break;
+        case 2: type = InternalServerError; break;
+        case 3: type = InternalServerError; break;
+        case 4: type = SlowDown; break;
         }
-        if((buffer.size() + response.size()) >= 1200)
+        emit networkError(type, meta);
+        return;
+    }
+
+    case 5: { // permanent failure
+        NetworkError type = UnknownError;
+        switch(secondary_code)
         {
-            emit networkError(ProtocolViolation, QObject::tr("META too large!"));
-            socket.close();
+        case 1: type = ResourceNotFound; break;
+        case 2: type = ResourceNotFound; break;
+        case 3: type = ProxyRequest; break;
+        case 9: type = BadRequest; break;
         }
-        buffer.append(response);
+        emit networkError(type, meta);
+        return;
+    }
+
+    case 6: // client certificate required
+        switch(secondary_code)
+        {
+        case 0:
+            emit certificateRequired(meta);
+            return;
+
+        case 1:
+            emit networkError(Unauthorized, meta);
+            return;
+
+        default:
+        case 2:
+            emit networkError(InvalidClientCertificate, meta);
+            return;
+        }
+        return;
+
+    default:
+        emit networkError(ProtocolViolation, QObject::tr("Unspecified status code used!"));
+        return;
     }
 }
 
 void GeminiClient::socketDisconnected()
 {
+    this->stopPhaseTimeout();
+
     if(this->is_receiving_body and not this->is_error_state) {
-        body.append(socket.readAll());
-        emit requestComplete(body, mime_type);
+        this->receiveBody();
+        if(this->is_error_state)
+            return;
+
+        if(body.isSpilled())
+            emit requestCompleteFile(body.takeFile(), mime_type);
+        else
+            emit requestComplete(body.data(), mime_type);
     }
 }
 
+void GeminiClient::receiveBody()
+{
+    qint64 const offset = body.size();
+    qint64 const len = body.readFrom(*socket);
+    if(len < 0) {
+        this->failBody();
+        return;
+    }
+    if(len == 0)
+        return;
+
+    // Chunks are only passed on while the document can still be displayed
+    if(not body.isSpilled())
+        emit this->responseData(body.data().mid(int(offset)));
+    emit this->requestProgress(body.size(), -1);
+}
+
+void GeminiClient::failBody()
+{
+    this->is_error_state = true;
+    this->is_receiving_body = false;
+    socket->close();
+
+    if(body.isLimitExceeded())
+        emit networkError(DownloadLimitExceeded, body.errorString());
+    else
+        emit networkError(UnknownError, body.errorString());
+
+    body.clear();
+}
+
 void GeminiClient::sslErrors(QList<QSslError> const & errors)
 {
-    emit this->hostCertificateLoaded(this->socket.peerCertificate());
+    emit this->hostCertificateLoaded(this->socket->peerCertificate());
 
     if(options & IgnoreTlsErrors) {
-        socket.ignoreSslErrors(errors);
+        socket->ignoreSslErrors(errors);
         return;
     }
 
@@ -341,7 +449,7 @@ void GeminiClient::sslErrors(QList<QSslError> const & errors)
         bool ignore = false;
         if(SslTrust::isTrustRelated(err.error()))
         {
-            switch(kristall::globals().trust.gemini.getTrust(target_url, socket.peerCertificate()))
+            switch(kristall::globals().trust.gemini.getTrust(target_url, socket->peerCertificate()))
             {
             case SslTrust::Trusted:
                 ignore = true;
@@ -349,12 +457,12 @@ void GeminiClient::sslErrors(QList<QSslError> const & errors)
             case SslTrust::Untrusted:
                 this->is_error_state = true;
                 this->suppress_socket_tls_error = true;
-                emit this->networkError(UntrustedHost, toFingerprintString(socket.peerCertificate()));
+                emit this->networkError(UntrustedHost, toFingerprintString(socket->peerCertificate()));
                 return;
             case SslTrust::Mistrusted:
                 this->is_error_state = true;
                 this->suppress_socket_tls_error = true;
-                emit this->networkError(MistrustedHost, toFingerprintString(socket.peerCertificate()));
+                emit this->networkError(MistrustedHost, toFingerprintString(socket->peerCertificate()));
                 return;
             }
         }
@@ -371,7 +479,7 @@ void GeminiClient::sslErrors(QList<QSslError> const & errors)
         }
     }
 
-    socket.ignoreSslErrors(ignored_errors);
+    socket->ignoreSslErrors(ignored_errors);
 
     qDebug() << "ignoring" << ignored_errors.size() << "out of" << errors.size();
 
@@ -380,22 +488,24 @@ void GeminiClient::sslErrors(QList<QSslError> const & errors)
     }
 
     if(remaining_errors.size() > 0) {
+        this->is_error_state = true;
+        this->suppress_socket_tls_error = true;
         emit this->networkError(TlsFailure, remaining_errors.first().errorString());
     }
 }
 
 void GeminiClient::socketError(QAbstractSocket::SocketError socketError)
 {
-    // When remote host closes TLS session, the client closes the socket.
+    // When remote host closes TLS session, the client closes the socket->
     // This is more sane then erroring out here as it's a perfectly legal
     // state and we know the TLS connection has ended.
     if(socketError == QAbstractSocket::RemoteHostClosedError) {
-        socket.close();
+        socket->close();
         return;
     }
 
     this->is_error_state = true;
     if(not this->suppress_socket_tls_error) {
-        this->emitNetworkError(socketError, socket.errorString());
+        this->emitNetworkError(socketError, socket->errorString());
     }
 }
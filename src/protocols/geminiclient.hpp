@@ -4,9 +4,14 @@
 #include <QObject>
 #include <QMimeType>
 #include <QSslSocket>
+#include <QSslConfiguration>
+#include <QSslKey>
 #include <QUrl>
 
 #include "protocolhandler.hpp"
+#include "geminiresponseparser.hpp"
+#include "responsebody.hpp"
+#include "hostconnector.hpp"
 
 class GeminiClient : public ProtocolHandler
 {
@@ -28,7 +33,13 @@ public:
     bool enableClientCertificate(CryptoIdentity const & ident) override;
     void disableClientCertificate() override;
 
+    //! Creates the TLS configuration for a connection to `url`.
+    //! Anonymous connections resume the last session with the host.
+    static QSslConfiguration createSslConfiguration(QUrl const & url, QSslCertificate const & certificate, QSslKey const & key);
+
 private slots:
+    void socketConnected(QAbstractSocket * connected_socket);
+
     void socketEncrypted();
 
     void socketReadyRead();
@@ -40,14 +51,40 @@ private slots:
     void socketError(QAbstractSocket::SocketError socketError);
 
 private:
+    //! Connects the signals of the socket to the client.
+    void attachSocket(QAbstractSocket * connected_socket);
+
+    //! Sends the request over a connection that was opened ahead of
+    //! time. Returns false if no such connection is available.
+    bool useWarmConnection();
+
+    //! Remembers the session ticket of the current connection for
+    //! resumption by the next request to the same host.
+    void storeSessionTicket();
+
+    //! Reads the available body data from the socket.
+    void receiveBody();
+
+    //! Aborts the request after the body couldn't be stored.
+    void failBody();
+
+private:
+    //! Most gemtext documents fit into the body buffer without reallocating
+    static constexpr int initial_body_capacity = 16 * 1024;
+
     bool is_receiving_body;
     bool suppress_socket_tls_error;
     bool is_error_state;
 
     QUrl target_url;
-    QSslSocket socket;
-    QByteArray buffer;
-    QByteArray body;
+    HostConnector connector;
+    //! The connection of the current request, owned by the client
+    QSslSocket * socket = nullptr;
+    QSslConfiguration ssl_config;
+    QSslCertificate client_certificate;
+    QSslKey client_key;
+    GeminiResponseParser parser;
+    ResponseBody body;
     QString mime_type;
     RequestOptions options;
 };
@@ -0,0 +1,127 @@
+#include "geminiresponseparser.hpp"
+
+#include <QObject>
+
+GeminiResponseParser::GeminiResponseParser()
+{
+    // A single allocation for the longest possible <META>
+    meta_bytes.reserve(max_header_length);
+    reset();
+}
+
+void GeminiResponseParser::reset()
+{
+    state = FirstDigit;
+    error = NoError;
+    primary_code = 0;
+    secondary_code = 0;
+    meta_bytes.resize(0);
+}
+
+GeminiResponseParser::Result GeminiResponseParser::feed(const char *data, qint64 length, qint64 &consumed)
+{
+    consumed = 0;
+
+    qint64 i = 0;
+    while(i < length)
+    {
+        char const c = data[i];
+        switch(state)
+        {
+        case FirstDigit:
+            if(c == '\r' or c == '\n')
+                return fail(TooShort);
+            if(c < '0' or c > '9')
+                return fail(FirstNotDigit);
+            primary_code = c - '0';
+            state = SecondDigit;
+            i += 1;
+            break;
+
+        case SecondDigit:
+            if(c == '\r' or c == '\n')
+                return fail(TooShort);
+            if(c < '0' or c > '9')
+                return fail(SecondNotDigit);
+            secondary_code = c - '0';
+            state = Separator;
+            i += 1;
+            break;
+
+        case Separator:
+            if(c == '\r' or c == '\n')
+                return fail(TooShort);
+            if(c != ' ' and c != '\t')
+                return fail(NoSeparator);
+            state = Meta;
+            i += 1;
+            break;
+
+        case Meta: {
+            // Copy everything up to the line end in one go
+            qint64 end = i;
+            while(end < length and data[end] != '\r' and data[end] != '\n')
+                end += 1;
+
+            // status, separator and <CR> <LF> are part of the header length
+            if(3 + meta_bytes.size() + (end - i) + 2 > max_header_length)
+                return fail(TooLong);
+
+            meta_bytes.append(data + i, int(end - i));
+            i = end;
+
+            if(i < length) {
+                if(data[i] == '\n')
+                    return fail(NoCarriageReturn);
+                state = LineFeed;
+                i += 1;
+            }
+            break;
+        }
+
+        case LineFeed:
+            if(c == '\n') {
+                state = Done;
+                consumed = i + 1;
+                return HeaderComplete;
+            }
+            // A lone <CR> is part of the meta
+            if(3 + meta_bytes.size() + 1 + 2 > max_header_length)
+                return fail(TooLong);
+            meta_bytes.append('\r');
+            state = Meta;
+            break;
+
+        case Done:
+            return HeaderComplete;
+
+        case Failed:
+            return Error;
+        }
+    }
+
+    consumed = length;
+    return NeedMoreData;
+}
+
+QString GeminiResponseParser::errorString() const
+{
+    switch(error)
+    {
+    case NoError: return QString { };
+    case TooShort: return QObject::tr("Line is too short for valid protocol");
+    case TooLong: return QObject::tr("META too large!");
+    case NoCarriageReturn: return QObject::tr("Line does not end with <CR> <LF>");
+    case FirstNotDigit: return QObject::tr("First character is not a digit.");
+    case SecondNotDigit: return QObject::tr("Second character is not a digit.");
+    case NoSeparator: return QObject::tr("Third character is not a space.");
+    }
+    return QString { };
+}
+
+GeminiResponseParser::Result GeminiResponseParser::fail(ErrorCode code)
+{
+    state = Failed;
+    error = code;
+    return Error;
+}
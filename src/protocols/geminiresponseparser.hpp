@@ -0,0 +1,74 @@
+#ifndef GEMINIRESPONSEPARSER_HPP
+#define GEMINIRESPONSEPARSER_HPP
+
+#include <QByteArray>
+#include <QString>
+
+//! Incremental parser for the gemini response header
+//! `<STATUS><SPACE><META><CR><LF>`.
+//! Data can be fed in arbitrary fragments, each byte is only looked at once.
+class GeminiResponseParser
+{
+public:
+    //! Maximum length of the header line including <CR> <LF>
+    static constexpr int max_header_length = 1200;
+
+    enum Result
+    {
+        NeedMoreData, //!< The header isn't complete yet
+        HeaderComplete, //!< The header was parsed, the remaining data is the body
+        Error, //!< The header is malformed, see `errorString()`
+    };
+
+public:
+    GeminiResponseParser();
+
+    //! Resets the parser for a new response.
+    void reset();
+
+    //! Parses the next fragment of the response.
+    //! When the header is complete, `consumed` is set to the number of bytes
+    //! in `data` that belong to the header. Everything after that is body.
+    Result feed(char const * data, qint64 length, qint64 & consumed);
+
+    int primaryCode() const { return primary_code; }
+    int secondaryCode() const { return secondary_code; }
+
+    //! The raw <META> of the response, without <CR> <LF>
+    QByteArray const & meta() const { return meta_bytes; }
+
+    QString errorString() const;
+
+private:
+    enum State
+    {
+        FirstDigit,
+        SecondDigit,
+        Separator,
+        Meta,
+        LineFeed,
+        Done,
+        Failed,
+    };
+
+    enum ErrorCode
+    {
+        NoError,
+        TooShort,
+        TooLong,
+        NoCarriageReturn,
+        FirstNotDigit,
+        SecondNotDigit,
+        NoSeparator,
+    };
+
+    Result fail(ErrorCode code);
+
+    State state;
+    ErrorCode error;
+    int primary_code;
+    int secondary_code;
+    QByteArray meta_bytes;
+};
+
+#endif // GEMINIRESPONSEPARSER_HPP
@@ -2,27 +2,25 @@
 #include "ioutil.hpp"
 #include "kristall.hpp"
 
+#include <QDebug>
+
+#include <cassert>
+
+#include <algorithm>
+
 GopherClient::GopherClient(QObject *parent) : ProtocolHandler(parent)
 {
-    connect(&socket, &QTcpSocket::connected, this, &GopherClient::on_connected);
-    connect(&socket, &QTcpSocket::readyRead, this, &GopherClient::on_readRead);
-    connect(&socket, &QTcpSocket::disconnected, this, &GopherClient::on_finished);
+    // Mirrors get the same head start as the addresses of a single host
+    this->mirror_timer.setSingleShot(true);
+    this->mirror_timer.setInterval(HostConnector::connection_attempt_delay);
+    connect(&this->mirror_timer, &QTimer::timeout, this, &GopherClient::on_mirrorTimeout);
 
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
-    connect(&socket, &QTcpSocket::errorOccurred, this, &GopherClient::on_socketError);
-#else
-    connect(&socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &GopherClient::on_socketError);
-#endif
-
-    connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
-        emit this->requestStateChange(RequestState::HostFound);
-    });
     emit this->requestStateChange(RequestState::None);
 }
 
 GopherClient::~GopherClient()
 {
-
+    HostConnector::disposeSocket(socket);
 }
 
 bool GopherClient::supportsScheme(const QString &scheme) const
@@ -64,64 +62,223 @@ bool GopherClient::startRequest(const QUrl &url, RequestOptions options)
 
     is_processing_binary = (type == "5") or (type == "9") or (type == "I") or (type == "g");
 
+    // Text is scanned for the terminator and must stay in memory
+    this->body.clear();
+    this->body.setSpillEnabled(is_processing_binary);
+    this->body.setMimeType(MimeParser::parse(mime));
+
     this->requested_url = url;
     this->was_cancelled = false;
-    socket.connectToHost(url.host(), url.port(70));
+    this->is_response_started = false;
+    this->emitted_size = 0;
+    this->scan_offset = 0;
+    if(socket != nullptr) {
+        HostConnector::closeSocket(socket);
+        socket = nullptr;
+    }
+
+    // Menu items with alternate servers are loaded from the first one that answers
+    this->targets = QList<QUrl> { url };
+    if(kristall::globals().options.gopher_mirror_racing)
+        this->targets.append(kristall::globals().gopher_mirrors.find(url));
+    this->started_targets = 1;
+    this->failed_targets = 0;
+    this->is_host_found = false;
+
+    this->startPhaseTimeout(HostTimings::HostLookup, url.host());
+    this->connectorFor(0)->connectToHost(url.host(), url.port(70), []() -> QAbstractSocket * {
+        return new QTcpSocket();
+    });
+    if(this->targets.size() > 1)
+        this->mirror_timer.start();
 
     return true;
 }
 
 bool GopherClient::isInProgress() const
 {
-    return socket.isOpen();
+    bool const is_connecting = std::any_of(connectors.begin(), connectors.end(), [](std::unique_ptr<HostConnector> const & connector) {
+        return connector->isConnecting();
+    });
+    return is_connecting or ((socket != nullptr) and socket->isOpen());
 }
 
 bool GopherClient::cancelRequest()
 {
     was_cancelled = true;
-    if (socket.state() != QTcpSocket::UnconnectedState)
+    this->stopPhaseTimeout();
+    this->mirror_timer.stop();
+    for(auto & connector : connectors)
+        connector->abort();
+    if (socket == nullptr)
     {
-        socket.disconnectFromHost();
-        socket.waitForDisconnected(1500);
+        body.clear();
+        return true;
     }
-    socket.close();
+    // The connection is shut down in the background, so the
+    // next request doesn't have to wait for it.
+    HostConnector::closeSocket(socket);
+    socket = nullptr;
     body.clear();
+    emit this->requestStateChange(RequestState::None);
     return true;
 }
 
+bool GopherClient::supportsClientCertificates() const
+{
+    return false;
+}
+
+HostConnector *GopherClient::connectorFor(int index)
+{
+    while(int(connectors.size()) <= index)
+    {
+        int const connector_index = int(connectors.size());
+        auto connector = std::make_unique<HostConnector>();
+
+        connect(connector.get(), &HostConnector::hostFound, this, [this]() {
+            if(this->is_host_found)
+                return;
+            this->is_host_found = true;
+            this->recordTiming(RequestTimings::HostFound);
+            this->startPhaseTimeout(HostTimings::Connect, this->requested_url.host());
+            emit this->requestStateChange(RequestState::HostFound);
+        });
+        connect(connector.get(), &HostConnector::connected, this, [this, connector_index](QAbstractSocket * connected_socket) {
+            this->on_targetConnected(connector_index, connected_socket);
+        });
+        connect(connector.get(), &HostConnector::connectionFailed, this, &GopherClient::on_targetFailed);
+
+        connectors.push_back(std::move(connector));
+    }
+    return connectors.at(size_t(index)).get();
+}
+
+void GopherClient::startMirrors()
+{
+    this->mirror_timer.stop();
+    while(this->started_targets < this->targets.size())
+    {
+        QUrl const & mirror = this->targets.at(this->started_targets);
+        this->connectorFor(this->started_targets)->connectToHost(mirror.host(), mirror.port(70), []() -> QAbstractSocket * {
+            return new QTcpSocket();
+        });
+        this->started_targets += 1;
+    }
+}
+
+void GopherClient::on_mirrorTimeout()
+{
+    this->startMirrors();
+}
+
+void GopherClient::on_targetConnected(int index, QAbstractSocket *connected_socket)
+{
+    // The first server that answers wins, all others are dropped
+    this->mirror_timer.stop();
+    for(auto & connector : connectors)
+        connector->abort();
+
+    // The selector of a mirror may differ from the requested one
+    if(index != 0)
+        qDebug() << "loading" << this->requested_url << "from mirror" << this->targets.at(index);
+    this->requested_url = this->targets.at(index);
+
+    this->on_socketConnected(connected_socket);
+}
+
+void GopherClient::on_targetFailed(QAbstractSocket::SocketError error, const QString &reason)
+{
+    this->failed_targets += 1;
+
+    // No need to wait for the head start of the mirrors anymore
+    if(this->started_targets < this->targets.size()) {
+        this->startMirrors();
+        return;
+    }
+
+    if(this->failed_targets < this->targets.size())
+        return;
+
+    this->stopPhaseTimeout();
+    this->emitNetworkError(error, reason);
+}
+
+void GopherClient::on_socketConnected(QAbstractSocket *connected_socket)
+{
+    if(socket != nullptr)
+        HostConnector::disposeSocket(socket);
+    socket = qobject_cast<QTcpSocket*>(connected_socket);
+    assert(socket != nullptr);
+
+    connect(socket, &QTcpSocket::readyRead, this, &GopherClient::on_readRead);
+    connect(socket, &QTcpSocket::disconnected, this, &GopherClient::on_finished);
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(socket, &QTcpSocket::errorOccurred, this, &GopherClient::on_socketError);
+#else
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, &GopherClient::on_socketError);
+#endif
+
+    this->recordTiming(RequestTimings::Connected);
+    this->on_connected();
+}
+
 void GopherClient::on_connected()
 {
     auto searchstr = requested_url.hasQuery() ? "\t" + requested_url.query() : QString();
     auto blob = (requested_url.path().mid(2) + searchstr + "\r\n").toUtf8();
 
-    IoUtil::writeAll(socket, blob);
+    IoUtil::writeAll(*socket, blob);
+    this->reportRequestSent(blob.size());
+
+    this->startPhaseTimeout(HostTimings::Response, this->requested_url.host());
 
     emit this->requestStateChange(RequestState::Connected);
 }
 
 void GopherClient::on_readRead()
 {
-    body.append(socket.readAll());
+    if(was_cancelled)
+        return;
 
-    if(not is_processing_binary) {
-        // Strip the "lone dot" from gopher data
-        if(int index = body.indexOf("\r\n.\r\n"); index >= 0) {
-            body.resize(index + 2);
-            socket.close();
-        }
+    this->reportDataReceived(socket->bytesAvailable());
+
+    if(body.readFrom(*socket) < 0) {
+        was_cancelled = true;
+        if(body.isLimitExceeded())
+            emit this->networkError(DownloadLimitExceeded, body.errorString());
+        else
+            emit this->networkError(UnknownError, body.errorString());
+        socket->close();
+        body.clear();
+        return;
+    }
+
+    if(not is_processing_binary and this->scanForTerminator()) {
+        socket->close();
     }
 
     if(not was_cancelled) {
-        emit this->requestProgress(body.size());
+        this->flushBody(false);
+        emit this->requestProgress(body.size(), -1);
     }
 }
 
 void GopherClient::on_finished()
 {
+    this->stopPhaseTimeout();
+
     if(not was_cancelled)
     {
         this->on_readRead();
-        emit this->requestComplete(this->body, mime);
+        if(not was_cancelled) {
+            this->flushBody(true);
+            if(body.isSpilled())
+                emit this->requestCompleteFile(this->body.takeFile(), mime);
+            else
+                emit this->requestComplete(this->body.data(), mime);
+        }
         was_cancelled = true;
     }
     body.clear();
@@ -129,14 +286,66 @@ void GopherClient::on_finished()
     emit this->requestStateChange(RequestState::None);
 }
 
+void GopherClient::flushBody(bool is_final)
+{
+    // Bodies in a file are not displayed anymore
+    if(body.isSpilled())
+        return;
+
+    QByteArray const & data = body.data();
+
+    int end = data.size();
+    if(not is_final and not is_processing_binary) {
+        // Only emit complete lines, so menus can be rendered as they arrive
+        // and a partial lone dot is never passed on.
+        while(end > emitted_size and data.at(end - 1) != '\n')
+            end -= 1;
+    }
+
+    if(not is_response_started) {
+        if(end <= emitted_size and not is_final)
+            return;
+        is_response_started = true;
+        emit this->responseStarted(mime);
+    }
+
+    if(end > emitted_size) {
+        emit this->responseData(data.mid(emitted_size, end - emitted_size));
+        emitted_size = end;
+    }
+}
+
+bool GopherClient::scanForTerminator()
+{
+    QByteArray const & data = body.data();
+
+    // An empty menu only consists of the lone dot
+    if(scan_offset < 3 and data.startsWith(".\r\n")) {
+        body.truncate(0);
+        return true;
+    }
+
+    // Everything before the scan offset was already searched, but the
+    // terminator might have been split between two reads.
+    int from = std::max(0, scan_offset - 4);
+    scan_offset = data.size();
+
+    if(int index = data.indexOf("\r\n.\r\n", from); index >= 0) {
+        body.truncate(index + 2);
+        scan_offset = index + 2;
+        return true;
+    }
+    return false;
+}
+
 void GopherClient::on_socketError(QAbstractSocket::SocketError error_code)
 {
     // When remote host closes session, the client closes the socket.
     // This is more sane then erroring out here as it's a perfectly legal
     // state and we know the connection has ended.
     if (error_code == QAbstractSocket::RemoteHostClosedError) {
-        socket.close();
+        socket->close();
         return;
     }
-    this->emitNetworkError(error_code, socket.errorString());
+    this->emitNetworkError(error_code, socket->errorString());
 }
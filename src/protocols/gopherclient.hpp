@@ -4,8 +4,15 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QUrl>
+#include <QList>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
 
 #include "protocolhandler.hpp"
+#include "hostconnector.hpp"
+#include "responsebody.hpp"
 
 class GopherClient : public ProtocolHandler
 {
@@ -23,20 +30,55 @@ public:
 
     bool cancelRequest() override;
 
+    bool supportsClientCertificates() const override;
+
 private: // slots
+    void on_targetConnected(int index, QAbstractSocket * connected_socket);
+    void on_targetFailed(QAbstractSocket::SocketError error, QString const & reason);
+    void on_mirrorTimeout();
+    void on_socketConnected(QAbstractSocket * connected_socket);
     void on_connected();
     void on_readRead();
     void on_finished();
     void on_socketError(QAbstractSocket::SocketError errorCode);
 
+private:
+    //! Emits the part of the body that wasn't passed to `responseData` yet.
+    //! Unless `is_final` is set, only complete lines of text bodies are
+    //! emitted, as an incomplete line might be the terminating lone dot.
+    void flushBody(bool is_final);
+
+    //! Searches the newly received text for the terminating lone dot
+    //! and strips it from the body. Returns true if it was found.
+    bool scanForTerminator();
+
+    //! Returns the connector for the target at `index`, creating it if needed.
+    HostConnector * connectorFor(int index);
+
+    //! Starts connecting to all mirrors that weren't tried yet.
+    void startMirrors();
 
 private:
-    QTcpSocket socket;
-    QByteArray body;
+    //! The requested item and its mirrors, which are raced against each other
+    QList<QUrl> targets;
+    //! One connector per target, reused between requests
+    std::vector<std::unique_ptr<HostConnector>> connectors;
+    //! Starts the mirrors if the requested server doesn't connect quickly
+    QTimer mirror_timer;
+    int started_targets;
+    int failed_targets;
+    bool is_host_found;
+    //! The connection of the current request, owned by the client
+    QTcpSocket * socket = nullptr;
+    ResponseBody body;
     QUrl requested_url;
     bool was_cancelled;
     QString mime;
     bool is_processing_binary;
+    bool is_response_started;
+    int emitted_size;
+    //! Position in the body up to which the terminator was searched
+    int scan_offset;
 };
 
 #endif // GOPHERCLIENT_HPP
@@ -0,0 +1,107 @@
+#include "offlinehandler.hpp"
+#include "kristall.hpp"
+
+#include <QUrl>
+#include <QStringList>
+
+#include <algorithm>
+#include <vector>
+
+OfflineHandler::OfflineHandler()
+{
+
+}
+
+bool OfflineHandler::supportsScheme(const QString &scheme) const
+{
+    return (scheme == "kristall+cache")
+        or (scheme == "gemini")
+        or (scheme == "gopher")
+        or (scheme == "finger");
+}
+
+bool OfflineHandler::startRequest(const QUrl &url, RequestOptions options)
+{
+    Q_UNUSED(options)
+
+    auto & cache = kristall::globals().cache;
+
+    if (url.scheme() != "kristall+cache")
+    {
+        if (auto pg = cache.find(url); pg != nullptr)
+            emit this->requestComplete(pg->body, pg->mime.toString());
+        else
+            emit this->networkError(Offline, tr("%1 is not cached.").arg(url.toString()));
+        return true;
+    }
+
+    if (not url.host().isEmpty())
+    {
+        QUrl const cached_url = resolveCacheUrl(url);
+        if (auto pg = cache.find(cached_url); pg != nullptr)
+            emit this->requestComplete(pg->body, pg->mime.toString());
+        else
+            emit this->networkError(ResourceNotFound, tr("%1 is not cached.").arg(url.toString()));
+        return true;
+    }
+
+    // Without a host, all cached pages are listed, most recent first
+    std::vector<std::shared_ptr<CachedPage>> pages;
+    for (auto const & entry : cache.getPages())
+        pages.push_back(entry.second);
+    std::sort(pages.begin(), pages.end(), [](auto const & a, auto const & b) {
+        return a->time_cached > b->time_cached;
+    });
+
+    QByteArray document;
+    document.append(tr("# Cached pages\n\n").toUtf8());
+    if (pages.empty())
+        document.append(tr("No pages are cached yet.\n").toUtf8());
+    for (auto const & pg : pages)
+    {
+        document.append(QString("=> %1 %2 (%3)\n")
+            .arg(toCacheUrl(pg->url).toString(QUrl::FullyEncoded), pg->url.toString(), pg->time_cached.toString(Qt::ISODate))
+            .toUtf8());
+    }
+
+    emit this->requestComplete(document, "text/gemini");
+    return true;
+}
+
+bool OfflineHandler::isInProgress() const
+{
+    return false;
+}
+
+bool OfflineHandler::cancelRequest()
+{
+    return true;
+}
+
+bool OfflineHandler::supportsClientCertificates() const
+{
+    return false;
+}
+
+QUrl OfflineHandler::resolveCacheUrl(const QUrl &url)
+{
+    // The cache URL doesn't tell the protocol, so all of them are tried
+    static const QStringList schemes { "gemini", "gopher", "finger", "https", "http" };
+
+    auto & cache = kristall::globals().cache;
+    for (auto const & scheme : schemes)
+    {
+        QUrl candidate = url.adjusted(QUrl::RemoveFragment);
+        candidate.setScheme(scheme);
+        if (cache.contains(candidate))
+            return candidate;
+    }
+    return QUrl { };
+}
+
+QUrl OfflineHandler::toCacheUrl(const QUrl &url)
+{
+    QUrl result = url;
+    result.setScheme("kristall+cache");
+    return result;
+}
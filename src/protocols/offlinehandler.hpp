@@ -0,0 +1,37 @@
+#ifndef OFFLINEHANDLER_HPP
+#define OFFLINEHANDLER_HPP
+
+#include <QObject>
+
+#include "protocolhandler.hpp"
+
+//! Serves pages from the page cache without accessing the network.
+//! Handles the kristall+cache scheme, where kristall+cache://host/path
+//! shows the cached copy of that page and kristall+cache: alone lists all
+//! cached pages. While offline mode is enabled, it also handles all
+//! gemini, gopher and finger requests.
+class OfflineHandler : public ProtocolHandler
+{
+    Q_OBJECT
+public:
+    OfflineHandler();
+
+    bool supportsScheme(QString const & scheme) const override;
+
+    bool startRequest(QUrl const & url, RequestOptions options) override;
+
+    bool isInProgress() const override;
+
+    bool cancelRequest() override;
+
+    bool supportsClientCertificates() const override;
+
+    //! Returns the cached URL a kristall+cache URL refers to, or an empty
+    //! URL if the page isn't cached.
+    static QUrl resolveCacheUrl(QUrl const & url);
+
+    //! Returns the kristall+cache URL that shows the cached copy of `url`.
+    static QUrl toCacheUrl(QUrl const & url);
+};
+
+#endif // OFFLINEHANDLER_HPP
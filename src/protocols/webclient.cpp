@@ -3,13 +3,12 @@
 
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QAbstractNetworkCache>
 
 WebClient::WebClient() :
     ProtocolHandler(nullptr),
     current_reply(nullptr)
 {
-    manager.setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
-
     emit this->requestStateChange(RequestState::None);
 }
 
@@ -35,32 +34,47 @@ bool WebClient::startRequest(const QUrl &url, RequestOptions options)
 
     this->options = options;
     this->body.clear();
+    this->is_response_started = false;
 
     QNetworkRequest request(url);
 
-    auto ssl_config = request.sslConfiguration();
-    // ssl_config.setProtocol(QSsl::TlsV1_2);
-    if(kristall::globals().trust.https.enable_ca)
-        ssl_config.setCaCertificates(QSslConfiguration::systemCaCertificates());
-    else
-        ssl_config.setCaCertificates(QList<QSslCertificate> { });
-
+    QSslCertificate certificate;
+    QSslKey key;
     if(this->current_identity.isValid()) {
-        ssl_config.setLocalCertificate(this->current_identity.certificate);
-        ssl_config.setPrivateKey(this->current_identity.private_key);
+        certificate = this->current_identity.certificate;
+        key = this->current_identity.private_key;
     }
+    auto const ssl_config = kristall::globals().ssl_configs.configuration(SslConfigCache::Https, certificate, key);
 
     // request.setMaximumRedirectsAllowed(5);
     request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::ManualRedirectPolicy);
     request.setSslConfiguration(ssl_config);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    // Connections are pooled by the shared manager and reused between requests
+    auto & manager = kristall::globals().network.webAccessManager(this->current_identity);
+
+    if(kristall::globals().options.offline_mode)
+    {
+        if(manager.cache() == nullptr or not manager.cache()->metaData(url).isValid()) {
+            emit this->requestStateChange(RequestState::None);
+            emit this->networkError(Offline, tr("%1 is not cached.").arg(url.toString()));
+            return true;
+        }
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysCache);
+    }
 
-    this->manager.clearAccessCache();
-    this->manager.clearConnectionCache();
     this->current_reply = manager.get(request);
     if(this->current_reply == nullptr)
         return false;
 
-    this->suppress_socket_tls_error = true;
+    // Set once a more specific error than the one of the reply was reported
+    this->suppress_socket_tls_error = false;
+    this->recordTiming(RequestTimings::RequestSent);
+
+    // The access manager doesn't expose the connection phases, so the
+    // response timeout and timings cover everything until the first data arrived.
+    this->startPhaseTimeout(HostTimings::Response, url.host());
 
     connect(this->current_reply, &QNetworkReply::readyRead, this, &WebClient::on_data);
     connect(this->current_reply, &QNetworkReply::finished, this,  &WebClient::on_finished);
@@ -77,8 +91,11 @@ bool WebClient::isInProgress() const
 
 bool WebClient::cancelRequest()
 {
+    this->stopPhaseTimeout();
     if(this->current_reply != nullptr)
     {
+        // Aborting finishes the reply, which must not be reported as an error
+        this->suppress_socket_tls_error = true;
         this->current_reply->abort();
         this->current_reply = nullptr;
     }
@@ -99,12 +116,45 @@ void WebClient::disableClientCertificate()
 
 void WebClient::on_data()
 {
-    this->body.append(this->current_reply->readAll());
-    emit this->requestProgress(this->body.size());
+    this->reportDataReceived(this->current_reply->bytesAvailable());
+
+    qint64 const offset = this->body.size();
+    if(offset == 0)
+        this->body.setMimeType(MimeParser::parse(this->current_reply->header(QNetworkRequest::ContentTypeHeader).toString()));
+    if(this->body.readFrom(*this->current_reply) < 0)
+    {
+        if(this->body.isLimitExceeded())
+            emit this->networkError(DownloadLimitExceeded, this->body.errorString());
+        else
+            emit this->networkError(UnknownError, this->body.errorString());
+
+        // Aborting finishes the reply, which must not report another error
+        this->suppress_socket_tls_error = true;
+        this->body.clear();
+        this->current_reply->abort();
+        return;
+    }
+
+    // Only successful responses are streamed, everything else
+    // is handled when the reply has finished.
+    int statusCode = this->current_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(statusCode >= 200 and statusCode < 300 and not this->body.isSpilled())
+    {
+        if(not this->is_response_started) {
+            this->is_response_started = true;
+            emit this->responseStarted(this->current_reply->header(QNetworkRequest::ContentTypeHeader).toString());
+        }
+        emit this->responseData(this->body.data().mid(int(offset)));
+    }
+
+    auto const content_length = this->current_reply->header(QNetworkRequest::ContentLengthHeader);
+    emit this->requestProgress(this->body.size(), content_length.isValid() ? content_length.toLongLong() : -1);
 }
 
 void WebClient::on_finished()
 {
+    this->stopPhaseTimeout();
+
     emit this->requestStateChange(RequestState::None);
 
     emit this->hostCertificateLoaded(this->current_reply->sslConfiguration().peerCertificate());
@@ -140,7 +190,7 @@ void WebClient::on_finished()
         }
 
         qDebug() << "web network error" << reply->errorString();
-        qDebug() << this->body;
+        qDebug() << this->body.data();
 
         if(not this->suppress_socket_tls_error) {
             emit this->networkError(error, reply->errorString());
@@ -152,7 +202,10 @@ void WebClient::on_finished()
 
         if(statusCode >= 200 and statusCode < 300) {
             auto mime = reply->header(QNetworkRequest::ContentTypeHeader).toString();
-            emit this->requestComplete(this->body, mime);
+            if(this->body.isSpilled())
+                emit this->requestCompleteFile(this->body.takeFile(), mime);
+            else
+                emit this->requestComplete(this->body.data(), mime);
         }
         else if(statusCode >= 300 and statusCode < 400) {
             auto url = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
@@ -225,6 +278,7 @@ void WebClient::on_sslErrors(const QList<QSslError> &errors)
     }
 
     if(remaining_errors.size() > 0) {
+        this->suppress_socket_tls_error = true;
         emit this->networkError(TlsFailure, remaining_errors.first().errorString());
     }
 }
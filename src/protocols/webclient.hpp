@@ -6,6 +6,7 @@
 #include <QNetworkReply>
 
 #include "protocolhandler.hpp"
+#include "responsebody.hpp"
 
 class WebClient: public ProtocolHandler
 {
@@ -34,15 +35,15 @@ private slots:
     void on_redirected(const QUrl &url);
 
 private:
-    QNetworkAccessManager manager;
     QNetworkReply * current_reply;
 
-    QByteArray body;
+    ResponseBody body;
     RequestOptions options;
 
     CryptoIdentity current_identity;
 
     bool suppress_socket_tls_error;
+    bool is_response_started;
 };
 
 #endif // WEBCLIENT_HPP
@@ -34,6 +34,7 @@ ProtocolSetup::ProtocolSupport ProtocolSetup::isSchemeSupported(QString const &
     // built-in schemes:
     if(scheme == "about") return Enabled;
     if(scheme == "file")  return Enabled;
+    if(scheme == "kristall+cache") return Enabled;
 
     return Unsupported;
 }
@@ -0,0 +1,130 @@
+#include "redirectcache.hpp"
+
+#include <QDebug>
+#include <QSet>
+
+QUrl RedirectCache::resolve(const QUrl &url)
+{
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    QUrl result = url;
+    QSet<QString> visited;
+    for(int i = 0; i < max_hops; i++)
+    {
+        auto const k = key(result);
+        auto it = this->redirects.find(k);
+        if(it == this->redirects.end())
+            break;
+
+        if(now >= it->expires) {
+            this->redirects.erase(it);
+            break;
+        }
+
+        // Don't follow remembered redirection loops
+        if(visited.contains(k))
+            break;
+        visited.insert(k);
+
+        result = it->target;
+    }
+
+    if(result != url and not result.hasFragment() and url.hasFragment())
+        result.setFragment(url.fragment());
+
+    return result;
+}
+
+void RedirectCache::store(const QUrl &from, const QUrl &to)
+{
+    if(not from.isValid() or not to.isValid() or key(from) == key(to))
+        return;
+
+    if(not this->redirects.contains(key(from)) and this->redirects.size() >= max_entries)
+        this->dropOldest();
+
+    this->redirects.insert(key(from), Redirect {
+        to.adjusted(QUrl::RemoveFragment),
+        QDateTime::currentDateTimeUtc().addSecs(default_lifetime),
+    });
+}
+
+void RedirectCache::remove(const QUrl &url)
+{
+    this->redirects.remove(key(url));
+}
+
+void RedirectCache::clear()
+{
+    this->redirects.clear();
+}
+
+int RedirectCache::size() const
+{
+    return this->redirects.size();
+}
+
+void RedirectCache::load(QSettings &settings)
+{
+    this->redirects.clear();
+
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    int size = settings.beginReadArray("redirects");
+    for(int i = 0; i < size; i++)
+    {
+        settings.setArrayIndex(i);
+
+        Redirect redirect {
+            settings.value("target").toUrl(),
+            settings.value("expires").toDateTime(),
+        };
+
+        // Drop everything that expired while we were not running
+        if(not redirect.target.isValid() or not redirect.expires.isValid() or now >= redirect.expires)
+            continue;
+
+        this->redirects.insert(settings.value("source").toString(), redirect);
+    }
+    settings.endArray();
+
+    qDebug() << "redirects: loaded" << this->redirects.size() << "permanent redirections";
+}
+
+void RedirectCache::save(QSettings &settings) const
+{
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    settings.remove("redirects");
+    settings.beginWriteArray("redirects");
+    int index = 0;
+    for(auto it = this->redirects.begin(); it != this->redirects.end(); ++it)
+    {
+        if(now >= it->expires)
+            continue;
+
+        settings.setArrayIndex(index);
+        settings.setValue("source", it.key());
+        settings.setValue("target", it->target);
+        settings.setValue("expires", it->expires);
+        index += 1;
+    }
+    settings.endArray();
+}
+
+QString RedirectCache::key(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments).toString(QUrl::FullyEncoded);
+}
+
+void RedirectCache::dropOldest()
+{
+    auto oldest = this->redirects.end();
+    for(auto it = this->redirects.begin(); it != this->redirects.end(); ++it)
+    {
+        if(oldest == this->redirects.end() or it->expires < oldest->expires)
+            oldest = it;
+    }
+    if(oldest != this->redirects.end())
+        this->redirects.erase(oldest);
+}
@@ -0,0 +1,57 @@
+#ifndef REDIRECTCACHE_HPP
+#define REDIRECTCACHE_HPP
+
+#include <QUrl>
+#include <QString>
+#include <QDateTime>
+#include <QSettings>
+#include <QHash>
+
+//! Remembers permanent redirections, so later requests to a
+//! moved location can go straight to the new location instead
+//! of doing a round trip to the old one first.
+class RedirectCache
+{
+public:
+    //! Lifetime of a remembered redirection (in seconds)
+    static constexpr int default_lifetime = 7 * 24 * 60 * 60;
+
+    //! Maximum number of remembered redirections
+    static constexpr int max_entries = 512;
+
+    //! Maximum number of remembered redirections followed by `resolve`
+    static constexpr int max_hops = 5;
+
+    //! Returns the final location of `url` by following all known
+    //! redirections, or `url` itself if it is not redirected.
+    //! The fragment of `url` is kept.
+    QUrl resolve(QUrl const & url);
+
+    //! Remembers that `from` was permanently redirected to `to`.
+    void store(QUrl const & from, QUrl const & to);
+
+    //! Forgets the redirection of `url`.
+    void remove(QUrl const & url);
+
+    void clear();
+
+    int size() const;
+
+    void load(QSettings & settings);
+    void save(QSettings & settings) const;
+
+private:
+    struct Redirect
+    {
+        QUrl target;
+        QDateTime expires;
+    };
+
+    static QString key(QUrl const & url);
+
+    void dropOldest();
+
+    QHash<QString, Redirect> redirects;
+};
+
+#endif // REDIRECTCACHE_HPP
@@ -8,6 +8,7 @@
 #include <QDebug>
 #include <QTextTable>
 #include <QRegularExpression>
+#include <cassert>
 
 #include "kristall.hpp"
 
@@ -37,272 +38,350 @@ std::unique_ptr<GeminiDocument> GeminiRenderer::render(
         DocumentOutlineModel &outline,
         QString & page_title)
 {
-    TextStyleInstance text_style { themed_style };
+    IncrementalGeminiRenderer renderer { root_url, themed_style, outline };
 
-    std::unique_ptr<GeminiDocument> result = std::make_unique<GeminiDocument>();
+    renderer.append(input);
+    renderer.finish();
+
+    // Use first heading as the page's title.
+    if (page_title.isEmpty())
+    {
+        page_title = renderer.pageTitle();
+    }
+
+    return renderer.takeDocument();
+}
+
+IncrementalGeminiRenderer::IncrementalGeminiRenderer(
+        QUrl const & root_url,
+        DocumentStyle const & themed_style,
+        DocumentOutlineModel & outline) :
+    root_url(root_url),
+    themed_style(themed_style),
+    text_style(themed_style),
+    outline(outline),
+    result(std::make_unique<GeminiDocument>()),
+    centre_first_h1(themed_style.centre_h1),
+    preformatted_fmt(text_style.preformatted)
+{
     renderhelpers::setPageMargins(result.get(), themed_style.margin_h, themed_style.margin_v);
     result->setIndentWidth(themed_style.indent_size);
 
-    QTextCursor cursor{result.get()};
+    this->cursor = QTextCursor { result.get() };
+
+    this->outline.clear();
+}
 
-    bool verbatim = false;
-    QTextList *current_list = nullptr;
-    bool blockquote = false;
+IncrementalGeminiRenderer::~IncrementalGeminiRenderer()
+{
+}
 
-    bool centre_first_h1 = themed_style.centre_h1;
+void IncrementalGeminiRenderer::append(const QByteArray &input)
+{
+    assert(not this->is_finished);
 
-    QTextCharFormat preformatted_fmt = text_style.preformatted;
+    this->input_size += input.size();
+    this->pending_input.append(input);
 
-    outline.beginBuild();
+    int start = 0;
+    int index;
+    while ((index = this->pending_input.indexOf('\n', start)) >= 0)
+    {
+        QByteArray line = this->pending_input.mid(start, index - start);
+        this->renderLine(line);
+        start = index + 1;
+    }
+    this->pending_input.remove(0, start);
+
+    if (this->outline_changed)
+    {
+        this->updateOutline();
+    }
+}
+
+void IncrementalGeminiRenderer::finish()
+{
+    if (this->is_finished)
+        return;
+
+    // The input is split at each line break, so whatever
+    // is left is the last line of the document.
+    this->renderLine(this->pending_input);
+    this->pending_input.clear();
+    this->is_finished = true;
+
+    this->updateOutline();
+}
+
+std::unique_ptr<GeminiDocument> IncrementalGeminiRenderer::takeDocument()
+{
+    this->is_finished = true;
+    this->cursor = QTextCursor { };
+    this->current_list = nullptr;
+    return std::move(this->result);
+}
+
+void IncrementalGeminiRenderer::updateOutline()
+{
+    this->outline.beginBuild();
+    for (auto const & heading : this->headings)
+    {
+        switch (heading.level)
+        {
+        case 1: this->outline.appendH1(heading.title, heading.anchor); break;
+        case 2: this->outline.appendH2(heading.title, heading.anchor); break;
+        case 3: this->outline.appendH3(heading.title, heading.anchor); break;
+        }
+    }
+    this->outline.endBuild();
 
-    int anchor_id = 0;
+    this->outline_changed = false;
+}
 
+void IncrementalGeminiRenderer::renderLine(QByteArray &line)
+{
     auto unique_anchor_name = [&]() -> QString {
         return QString("auto-title-%1").arg(++anchor_id);
     };
 
-    QList<QByteArray> lines = input.split('\n');
-    for (auto &line : lines)
-    {
-        line.replace("\r", "");
+    line.replace("\r", "");
 
-        if (verbatim)
+    if (verbatim)
+    {
+        if (line.startsWith("```"))
         {
-            if (line.startsWith("```"))
-            {
-                // Set the last line of the preformatted block to have
-                // standard line height.
-                QTextBlockFormat fmt = text_style.preformatted_format;
-                fmt.setLineHeight(themed_style.line_height_p, QTextBlockFormat::LineDistanceHeight);
-                cursor.movePosition(QTextCursor::PreviousBlock);
-                cursor.setBlockFormat(fmt);
-
-                cursor.movePosition(QTextCursor::NextBlock);
-                cursor.setBlockFormat(text_style.standard_format);
-                verbatim = false;
-            }
-            else
-            {
-                cursor.setBlockFormat(text_style.preformatted_format);
-                renderhelpers::renderEscapeCodes(line, preformatted_fmt, text_style.preformatted, cursor);
-                cursor.insertText("\n", text_style.preformatted);
-            }
+            // Set the last line of the preformatted block to have
+            // standard line height.
+            QTextBlockFormat fmt = text_style.preformatted_format;
+            fmt.setLineHeight(themed_style.line_height_p, QTextBlockFormat::LineDistanceHeight);
+            cursor.movePosition(QTextCursor::PreviousBlock);
+            cursor.setBlockFormat(fmt);
 
-            continue;
+            cursor.movePosition(QTextCursor::NextBlock);
+            cursor.setBlockFormat(text_style.standard_format);
+            verbatim = false;
         }
-
-        // List item
-        if (line.startsWith("* "))
+        else
         {
-            if (current_list == nullptr)
-            {
-                cursor.deletePreviousChar();
-                cursor.insertBlock();
-                cursor.setBlockFormat(text_style.standard_format);
-                current_list = cursor.createList(text_style.list_format);
-            }
-            else
-            {
-                cursor.insertBlock();
-            }
-
-            renderhelpers::replace_quotes(line);
-            insertText(cursor, trim_whitespace(line.mid(1)), text_style.standard);
-            continue;
+            cursor.setBlockFormat(text_style.preformatted_format);
+            renderhelpers::renderEscapeCodes(line, preformatted_fmt, text_style.preformatted, cursor);
+            cursor.insertText("\n", text_style.preformatted);
         }
 
-        // End of list
-        if (current_list != nullptr)
+        return;
+    }
+
+    // List item
+    if (line.startsWith("* "))
+    {
+        if (current_list == nullptr)
         {
+            cursor.deletePreviousChar();
             cursor.insertBlock();
             cursor.setBlockFormat(text_style.standard_format);
+            current_list = cursor.createList(text_style.list_format);
         }
-        current_list = nullptr;
-
-        // Block quote
-        if(line.startsWith(">"))
+        else
         {
-            if(!blockquote)
-            {
-                // Start blockquote
-                QTextTable *table = cursor.insertTable(1, 1, text_style.blockquote_tableformat);
-                cursor.setBlockFormat(text_style.blockquote_format);
-                QTextTableCell cell = table->cellAt(0, 0);
-                cell.setFormat(text_style.blockquote);
-                blockquote = true;
-            }
-
-            renderhelpers::replace_quotes(line);
-            insertText(cursor, trim_whitespace(line.mid(1)), text_style.blockquote);
-            cursor.insertText("\n", text_style.standard);
-            continue;
+            cursor.insertBlock();
         }
 
-        // End of blockquote
-        if (blockquote)
+        renderhelpers::replace_quotes(line);
+        insertText(cursor, trim_whitespace(line.mid(1)), text_style.standard);
+        return;
+    }
+
+    // End of list
+    if (current_list != nullptr)
+    {
+        cursor.insertBlock();
+        cursor.setBlockFormat(text_style.standard_format);
+    }
+    current_list = nullptr;
+
+    // Block quote
+    if(line.startsWith(">"))
+    {
+        if(!blockquote)
         {
-            cursor.deletePreviousChar();
-            cursor.movePosition(QTextCursor::NextBlock);
-            cursor.setBlockFormat(text_style.standard_format);
+            // Start blockquote
+            QTextTable *table = cursor.insertTable(1, 1, text_style.blockquote_tableformat);
+            cursor.setBlockFormat(text_style.blockquote_format);
+            QTextTableCell cell = table->cellAt(0, 0);
+            cell.setFormat(text_style.blockquote);
+            blockquote = true;
         }
-        blockquote = false;
 
-        // Headings, etc.
-        if (line.startsWith("###"))
-        {
-            auto heading = trim_whitespace(line.mid(3));
+        renderhelpers::replace_quotes(line);
+        insertText(cursor, trim_whitespace(line.mid(1)), text_style.blockquote);
+        cursor.insertText("\n", text_style.standard);
+        return;
+    }
 
-            auto id = unique_anchor_name();
-            auto fmt = text_style.standard_h3;
-            fmt.setAnchor(true);
-            fmt.setAnchorNames(QStringList { id });
+    // End of blockquote
+    if (blockquote)
+    {
+        cursor.deletePreviousChar();
+        cursor.movePosition(QTextCursor::NextBlock);
+        cursor.setBlockFormat(text_style.standard_format);
+    }
+    blockquote = false;
 
-            outline.appendH3(heading, id);
+    // Headings, etc.
+    if (line.startsWith("###"))
+    {
+        auto heading = trim_whitespace(line.mid(3));
 
-            cursor.setBlockFormat(text_style.heading_format);
-            insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
-            cursor.insertText("\n", text_style.standard);
-        }
-        else if (line.startsWith("##"))
-        {
-            auto heading = trim_whitespace(line.mid(2));
+        auto id = unique_anchor_name();
+        auto fmt = text_style.standard_h3;
+        fmt.setAnchor(true);
+        fmt.setAnchorNames(QStringList { id });
 
-            auto id = unique_anchor_name();
-            auto fmt = text_style.standard_h2;
-            fmt.setAnchor(true);
-            fmt.setAnchorNames(QStringList { id });
+        headings.append(Heading { 3, heading, id });
+        outline_changed = true;
 
-            outline.appendH2(heading, id);
+        cursor.setBlockFormat(text_style.heading_format);
+        insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
+        cursor.insertText("\n", text_style.standard);
+    }
+    else if (line.startsWith("##"))
+    {
+        auto heading = trim_whitespace(line.mid(2));
 
-            cursor.setBlockFormat(text_style.heading_format);
-            insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
-            cursor.insertText("\n", text_style.standard);
-        }
-        else if (line.startsWith("#"))
-        {
-            auto heading = trim_whitespace(line.mid(1));
+        auto id = unique_anchor_name();
+        auto fmt = text_style.standard_h2;
+        fmt.setAnchor(true);
+        fmt.setAnchorNames(QStringList { id });
 
-            auto id = unique_anchor_name();
-            auto fmt = text_style.standard_h1;
-            fmt.setAnchor(true);
-            fmt.setAnchorNames(QStringList { id });
+        headings.append(Heading { 2, heading, id });
+        outline_changed = true;
 
-            outline.appendH1(heading, id);
+        cursor.setBlockFormat(text_style.heading_format);
+        insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
+        cursor.insertText("\n", text_style.standard);
+    }
+    else if (line.startsWith("#"))
+    {
+        auto heading = trim_whitespace(line.mid(1));
 
-            // Use first heading as the page's title.
-            if (page_title.isEmpty())
-            {
-                    page_title = heading;
-            }
+        auto id = unique_anchor_name();
+        auto fmt = text_style.standard_h1;
+        fmt.setAnchor(true);
+        fmt.setAnchorNames(QStringList { id });
 
-            // Centre the first heading. We can't use the above code block
-            // for this because it doesn't get run on every re-render of the page
-            if (centre_first_h1)
-            {
-                auto f = text_style.heading_format;
-                f.setAlignment(Qt::AlignCenter);
-                cursor.setBlockFormat(f);
-                centre_first_h1 = false;
-            }
-            else
-            {
-                cursor.setBlockFormat(text_style.heading_format);
-            }
+        headings.append(Heading { 1, heading, id });
+        outline_changed = true;
 
-            insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
-            cursor.insertText("\n", text_style.standard);
+        // Use first heading as the page's title.
+        if (page_title.isEmpty())
+        {
+                page_title = heading;
         }
-        else if (line.startsWith("=>"))
+
+        // Centre the first heading. We can't use the above code block
+        // for this because it doesn't get run on every re-render of the page
+        if (centre_first_h1)
         {
-            auto const part = line.mid(2).trimmed();
+            auto f = text_style.heading_format;
+            f.setAlignment(Qt::AlignCenter);
+            cursor.setBlockFormat(f);
+            centre_first_h1 = false;
+        }
+        else
+        {
+            cursor.setBlockFormat(text_style.heading_format);
+        }
 
-            QByteArray link, title;
+        insertText(cursor, renderhelpers::replace_quotes(heading), fmt);
+        cursor.insertText("\n", text_style.standard);
+    }
+    else if (line.startsWith("=>"))
+    {
+        auto const part = line.mid(2).trimmed();
 
-            int index = -1;
-            for (int i = 0; i < part.size(); i++)
-            {
-                if (isspace(part[i]))
-                {
-                    index = i;
-                    break;
-                }
-            }
+        QByteArray link, title;
 
-            if (index > 0)
-            {
-                link = trim_whitespace(part.mid(0, index));
-                title = trim_whitespace(part.mid(index + 1));
-            }
-            else
+        int index = -1;
+        for (int i = 0; i < part.size(); i++)
+        {
+            if (isspace(part[i]))
             {
-                link = trim_whitespace(part);
-                title = trim_whitespace(part);
+                index = i;
+                break;
             }
-            renderhelpers::replace_quotes(title);
+        }
 
-            auto local_url = QUrl(link);
+        if (index > 0)
+        {
+            link = trim_whitespace(part.mid(0, index));
+            title = trim_whitespace(part.mid(index + 1));
+        }
+        else
+        {
+            link = trim_whitespace(part);
+            title = trim_whitespace(part);
+        }
+        renderhelpers::replace_quotes(title);
 
-            // Makes relative URLs with scheme provided (e.g gemini:///relative) work
-            // From RFC 1630: "If the scheme parts are different, the whole absolute URI must be given"
-            // therefor the schemes must be same for this to be allowed.
-            if (local_url.scheme() == root_url.scheme() &&
-                local_url.authority().isEmpty() &&
-                local_url.scheme() != "about" &&
-                local_url.scheme() != "file")
-            {
-                // qDebug() << "Adjusting local url: " << local_url;
-                local_url = local_url.adjusted(QUrl::RemoveScheme | QUrl::RemoveAuthority);
-            }
-            auto absolute_url = root_url.resolved(local_url);
+        auto local_url = QUrl(link);
 
-            // qDebug() << link << title;
+        // Makes relative URLs with scheme provided (e.g gemini:///relative) work
+        // From RFC 1630: "If the scheme parts are different, the whole absolute URI must be given"
+        // therefor the schemes must be same for this to be allowed.
+        if (local_url.scheme() == root_url.scheme() &&
+            local_url.authority().isEmpty() &&
+            local_url.scheme() != "about" &&
+            local_url.scheme() != "file")
+        {
+            // qDebug() << "Adjusting local url: " << local_url;
+            local_url = local_url.adjusted(QUrl::RemoveScheme | QUrl::RemoveAuthority);
+        }
+        auto absolute_url = root_url.resolved(local_url);
 
-            auto fmt = text_style.standard_link;
+        // qDebug() << link << title;
 
-            QString prefix;
-            if (absolute_url.host() == root_url.host())
-            {
-                prefix = themed_style.internal_link_prefix;
-                fmt = text_style.standard_link;
-            }
-            else
-            {
-                prefix = themed_style.external_link_prefix;
-                fmt = text_style.external_link;
-            }
+        auto fmt = text_style.standard_link;
 
-            QString suffix = "";
-            if (absolute_url.scheme() != root_url.scheme())
-            {
-                if(absolute_url.scheme() != "kristall+ctrl") {
-                    suffix = " [" + absolute_url.scheme().toUpper() + "]";
-                    fmt = text_style.cross_protocol_link;
-                }
-            }
-
-            fmt.setAnchor(true);
-            fmt.setAnchorHref(absolute_url.toString());
-            cursor.setBlockFormat(text_style.link_format);
-            insertText(cursor, (prefix + title + suffix).toUtf8(), fmt);
-            cursor.insertText("\n", text_style.standard);
-        }
-        else if (line.startsWith("```"))
+        QString prefix;
+        if (absolute_url.host() == root_url.host())
         {
-            verbatim = true;
-            preformatted_fmt = text_style.preformatted;
+            prefix = themed_style.internal_link_prefix;
+            fmt = text_style.standard_link;
         }
         else
         {
-            cursor.setBlockFormat(text_style.standard_format);
+            prefix = themed_style.external_link_prefix;
+            fmt = text_style.external_link;
+        }
 
-            renderhelpers::replace_quotes(line);
-            insertText(cursor, line, text_style.standard);
-            cursor.insertText("\n", text_style.standard);
+        QString suffix = "";
+        if (absolute_url.scheme() != root_url.scheme())
+        {
+            if(absolute_url.scheme() != "kristall+ctrl") {
+                suffix = " [" + absolute_url.scheme().toUpper() + "]";
+                fmt = text_style.cross_protocol_link;
+            }
         }
+
+        fmt.setAnchor(true);
+        fmt.setAnchorHref(absolute_url.toString());
+        cursor.setBlockFormat(text_style.link_format);
+        insertText(cursor, (prefix + title + suffix).toUtf8(), fmt);
+        cursor.insertText("\n", text_style.standard);
     }
+    else if (line.startsWith("```"))
+    {
+        verbatim = true;
+        preformatted_fmt = text_style.preformatted;
+    }
+    else
+    {
+        cursor.setBlockFormat(text_style.standard_format);
 
-    outline.endBuild();
-    return result;
+        renderhelpers::replace_quotes(line);
+        insertText(cursor, line, text_style.standard);
+        cursor.insertText("\n", text_style.standard);
+    }
 }
 
 GeminiDocument::GeminiDocument(QObject *parent) : QTextDocument(parent)
@@ -3,13 +3,20 @@
 
 #include <memory>
 #include <QTextDocument>
+#include <QTextCursor>
 #include <QColor>
 #include <QSettings>
+#include <QUrl>
+#include <QList>
 
 #include "documentoutlinemodel.hpp"
 
 #include "documentstyle.hpp"
 
+#include "textstyleinstance.hpp"
+
+class QTextList;
+
 class GeminiDocument :
         public QTextDocument
 {
@@ -38,4 +45,90 @@ struct GeminiRenderer
     );
 };
 
+//! Renders a gemtext document line by line. The parser state is kept
+//! between calls to `append`, so a document can be rendered while it
+//! is still being received. Rendering the input in chunks yields the
+//! same document as `GeminiRenderer::render`.
+class IncrementalGeminiRenderer
+{
+public:
+    //! @param root_url The url that is used to resolve relative links
+    //! @param style    The style which is used to render the document
+    //! @param outline  Receives the outline of the document. Must outlive the renderer.
+    IncrementalGeminiRenderer(
+        QUrl const & root_url,
+        DocumentStyle const & style,
+        DocumentOutlineModel & outline
+    );
+
+    IncrementalGeminiRenderer(IncrementalGeminiRenderer const &) = delete;
+    IncrementalGeminiRenderer & operator=(IncrementalGeminiRenderer const &) = delete;
+
+    ~IncrementalGeminiRenderer();
+
+    //! Appends the utf8 encoded input to the document. Only complete lines
+    //! are rendered, an incomplete last line is kept until more input
+    //! arrives or `finish` is called.
+    void append(QByteArray const & input);
+
+    //! Renders the remaining input and completes the outline.
+    void finish();
+
+    //! The document that is rendered into. Stays valid until `takeDocument`
+    //! is called or the renderer is destroyed.
+    GeminiDocument * document() const {
+        return this->result.get();
+    }
+
+    //! Transfers ownership of the document to the caller.
+    //! No further input may be appended after that.
+    std::unique_ptr<GeminiDocument> takeDocument();
+
+    //! The text of the first H1 heading or an empty string.
+    QString const & pageTitle() const {
+        return this->page_title;
+    }
+
+    //! Total number of bytes passed to `append`.
+    qint64 inputSize() const {
+        return this->input_size;
+    }
+
+private:
+    void renderLine(QByteArray & line);
+
+    void updateOutline();
+
+private:
+    struct Heading
+    {
+        int level;
+        QString title;
+        QString anchor;
+    };
+
+    QUrl root_url;
+    DocumentStyle themed_style;
+    TextStyleInstance text_style;
+    DocumentOutlineModel & outline;
+
+    std::unique_ptr<GeminiDocument> result;
+    QTextCursor cursor;
+
+    QByteArray pending_input;
+    qint64 input_size = 0;
+    bool is_finished = false;
+
+    bool verbatim = false;
+    QTextList * current_list = nullptr;
+    bool blockquote = false;
+    bool centre_first_h1;
+    QTextCharFormat preformatted_fmt;
+    int anchor_id = 0;
+
+    QList<Heading> headings;
+    bool outline_changed = false;
+    QString page_title;
+};
+
 #endif // GEMINIRENDERER_HPP
@@ -15,21 +15,29 @@
 
 std::unique_ptr<QTextDocument> GophermapRenderer::render(const QByteArray &input, const QUrl &root_url, const DocumentStyle &themed_style)
 {
-    QTextCharFormat standard;
-    standard.setFont(themed_style.preformatted_font);
-    standard.setForeground(themed_style.preformatted_color);
+    IncrementalGophermapRenderer renderer { root_url, themed_style };
 
-    QTextCharFormat standard_link;
-    standard_link.setFont(themed_style.preformatted_font);
-    standard_link.setForeground(QBrush(themed_style.internal_link_color));
+    renderer.append(input);
+    renderer.finish();
 
-    QTextCharFormat external_link;
-    external_link.setFont(themed_style.standard_font);
-    external_link.setForeground(QBrush(themed_style.external_link_color));
+    return renderer.takeDocument();
+}
+
+IncrementalGophermapRenderer::IncrementalGophermapRenderer(const QUrl &root_url, const DocumentStyle &themed_style) :
+    root_url(root_url),
+    themed_style(themed_style),
+    result(std::make_unique<QTextDocument>()),
+    emit_text_only(kristall::globals().options.gophermap_display == GenericSettings::PlainText),
+    race_mirrors(kristall::globals().options.gopher_mirror_racing)
+{
+    this->standard.setFont(themed_style.preformatted_font);
+    this->standard.setForeground(themed_style.preformatted_color);
+
+    this->standard_link.setFont(themed_style.preformatted_font);
+    this->standard_link.setForeground(QBrush(themed_style.internal_link_color));
 
-    bool emit_text_only = (kristall::globals().options.gophermap_display == GenericSettings::PlainText);
+    this->text_fmt = this->standard;
 
-    std::unique_ptr<QTextDocument> result = std::make_unique<QTextDocument>();
     renderhelpers::setPageMargins(result.get(), themed_style.margin_h, themed_style.margin_v);
 
     if(not emit_text_only)
@@ -39,8 +47,6 @@ std::unique_ptr<QTextDocument> GophermapRenderer::render(const QByteArray &input
             icon_prefix = ":/icons/dark/gopher/";
         else
             icon_prefix = ":/icons/light/gopher/";
-        qDebug() << "lightness" << themed_style.background_color.lightnessF();
-        qDebug() << "value" << themed_style.background_color.valueF();
 
         result->addResource(QTextDocument::ImageResource, QUrl("gopher/binary"), QVariant::fromValue(QImage(icon_prefix + "binary.svg")));
         result->addResource(QTextDocument::ImageResource, QUrl("gopher/directory"), QVariant::fromValue(QImage(icon_prefix + "directory.svg")));
@@ -56,150 +62,192 @@ std::unique_ptr<QTextDocument> GophermapRenderer::render(const QByteArray &input
         result->addResource(QTextDocument::ImageResource, QUrl("gopher/text"), QVariant::fromValue(QImage(icon_prefix + "text.svg")));
     }
 
-    QTextCursor cursor{result.get()};
+    this->cursor = QTextCursor { result.get() };
+}
 
-    QTextBlockFormat non_list_format = cursor.blockFormat();
+IncrementalGophermapRenderer::~IncrementalGophermapRenderer()
+{
+}
 
-    QTextCharFormat text_fmt = standard;
+void IncrementalGophermapRenderer::append(const QByteArray &input)
+{
+    assert(not this->is_finished);
 
-    char last_type = '1';
+    this->input_size += input.size();
+    this->pending_input.append(input);
 
-    QList<QByteArray> lines = input.split('\n');
-    for (auto const &line : lines)
+    int start = 0;
+    int index;
+    while ((index = this->pending_input.indexOf('\n', start)) >= 0)
     {
-        if (line.length() < 2) // skip lines without
-            continue;
+        this->renderLine(this->pending_input.mid(start, index - start));
+        start = index + 1;
+    }
+    this->pending_input.remove(0, start);
+}
 
-        if (line[line.size() - 1] != '\r')
-            continue;
+void IncrementalGophermapRenderer::finish()
+{
+    if (this->is_finished)
+        return;
 
-        auto items = line.mid(1, line.length() - 2).split('\t');
-        if (items.size() < 2) // invalid
-            continue;
+    this->renderLine(this->pending_input);
+    this->pending_input.clear();
+    this->is_finished = true;
+}
 
-        QString icon;
-        QString scheme = "gopher";
+std::unique_ptr<QTextDocument> IncrementalGophermapRenderer::takeDocument()
+{
+    this->is_finished = true;
+    this->cursor = QTextCursor { };
+    return std::move(this->result);
+}
+
+void IncrementalGophermapRenderer::renderLine(const QByteArray &line)
+{
+    if (line.length() < 2) // skip lines without
+        return;
+
+    if (line[line.size() - 1] != '\r')
+        return;
+
+    auto items = line.mid(1, line.length() - 2).split('\t');
+    if (items.size() < 2) // invalid
+        return;
+
+    QString icon;
+    QString scheme = "gopher";
 
-        auto type = line.at(0);
-        switch (type)
+    auto type = line.at(0);
+    switch (type)
+    {
+    case '0': // Text File
+        icon = "text";
+        break;
+    case '1': // Gopher submenu or link to another gopher server
+        icon = "directory";
+        break;
+    case '2': // CCSO Nameserver
+        icon = "dns";
+        break;
+    case '3': // Error code returned by a Gopher server to indicate failure
+        icon = "error";
+        break;
+    case '4': // BinHex-encoded file (primarily for Macintosh computers)
+        icon = "binary";
+        break;
+    case '5': // DOS file
+        icon = "binary";
+        break;
+    case '6': // uuencoded file
+        icon = "binary";
+        break;
+    case '7': // Gopher full-text search
+        icon = "search";
+        break;
+    case '8': // Telnet
+        icon = "telnet";
+        scheme = "telnet";
+        break;
+    case '9': // Binary file
+        icon = "binary";
+        break;
+    case '+': // Mirror or alternate server (for load balancing or in case of primary server downtime)
+        icon = "mirror";
+        break;
+    case 'g': // GIF file
+        icon = "gif";
+        break;
+    case 'I': // Image file
+        icon = "image";
+        break;
+    case 'T': // Telnet 3270
+        icon = "telnet";
+        scheme = "telnet";
+        break;
+    //Non-Canonical Types
+    case 'h': // HTML file
+        icon = "html";
+        break;
+    case 'i': // Informational message
+        icon = "informational";
+        break;
+    case 's': // Sound file
+        icon = "sound";
+        break;
+    default: // unknown
+        return;
+    }
+    bool const is_mirror = (type == '+');
+    if(type == '+') {
+        type = this->last_type;
+    } else {
+        this->last_type = type;
+    }
+
+    QString title = items.at(0);
+
+    if (type == 'i')
+    {
+        this->last_link.clear();
+
+        const QString escapeRenderInput = title + "\n";
+        renderhelpers::renderEscapeCodes(escapeRenderInput.toUtf8(), this->text_fmt, this->standard, this->cursor);
+    }
+    else
+    {
+        QString dst_url;
+        switch (items.size())
         {
-        case '0': // Text File
-            icon = "text";
-            break;
-        case '1': // Gopher submenu or link to another gopher server
-            icon = "directory";
-            break;
-        case '2': // CCSO Nameserver
-            icon = "dns";
-            break;
-        case '3': // Error code returned by a Gopher server to indicate failure
-            icon = "error";
-            break;
-        case '4': // BinHex-encoded file (primarily for Macintosh computers)
-            icon = "binary";
-            break;
-        case '5': // DOS file
-            icon = "binary";
-            break;
-        case '6': // uuencoded file
-            icon = "binary";
-            break;
-        case '7': // Gopher full-text search
-            icon = "search";
-            break;
-        case '8': // Telnet
-            icon = "telnet";
-            scheme = "telnet";
-            break;
-        case '9': // Binary file
-            icon = "binary";
+        case 0:
+            assert(false);
+        case 1:
+            assert(false);
+        case 2:
+            dst_url = this->root_url.resolved(QUrl(items.at(1))).toString();
             break;
-        case '+': // Mirror or alternate server (for load balancing or in case of primary server downtime)
-            icon = "mirror";
+        case 3:
+            dst_url = scheme + "://" + items.at(2) + "/" + QString(type) + items.at(1);
             break;
-        case 'g': // GIF file
-            icon = "gif";
+        default:
+            dst_url = scheme + "://" + items.at(2) + ":" + items.at(3) + "/" + QString(type) + items.at(1);
             break;
-        case 'I': // Image file
-            icon = "image";
-            break;
-        case 'T': // Telnet 3270
-            icon = "telnet";
-            scheme = "telnet";
-            break;
-        //Non-Canonical Types
-        case 'h': // HTML file
-            icon = "html";
-            break;
-        case 'i': // Informational message
-            icon = "informational";
-            break;
-        case 's': // Sound file
-            icon = "sound";
-            break;
-        default: // unknown
-            continue;
         }
-        if(type == '+') {
-            type = last_type;
-        } else {
-            last_type = type;
+
+        if (not QUrl(dst_url).isValid())
+        {
+            // invlaid URL generated
+            qDebug() << line << dst_url;
         }
 
-        QString title = items.at(0);
+        // The client races the mirrors of an item, so they
+        // are not listed as separate items.
+        if(is_mirror and this->race_mirrors and not this->last_link.isEmpty())
+        {
+            kristall::globals().gopher_mirrors.add(QUrl(this->last_link), QUrl(dst_url));
+            return;
+        }
+        if(not is_mirror)
+            this->last_link = dst_url;
 
-        if (type == 'i')
+        if(this->emit_text_only)
         {
-            const QString escapeRenderInput = title + "\n";
-            renderhelpers::renderEscapeCodes(escapeRenderInput.toUtf8(), text_fmt, standard, cursor);
+            this->cursor.insertText("[" + icon + "] ", this->standard);
         }
         else
         {
-            QString dst_url;
-            switch (items.size())
-            {
-            case 0:
-                assert(false);
-            case 1:
-                assert(false);
-            case 2:
-                dst_url = root_url.resolved(QUrl(items.at(1))).toString();
-                break;
-            case 3:
-                dst_url = scheme + "://" + items.at(2) + "/" + QString(type) + items.at(1);
-                break;
-            default:
-                dst_url = scheme + "://" + items.at(2) + ":" + items.at(3) + "/" + QString(type) + items.at(1);
-                break;
-            }
-
-            if (not QUrl(dst_url).isValid())
-            {
-                // invlaid URL generated
-                qDebug() << line << dst_url;
-            }
-
-            if(emit_text_only)
-            {
-                cursor.insertText("[" + icon + "] ", standard);
-            }
-            else
-            {
-                QTextImageFormat icon_fmt;
-                icon_fmt.setFont(themed_style.preformatted_font);
-                icon_fmt.setName(QString("gopher/%1").arg(icon));
-                icon_fmt.setVerticalAlignment(QTextImageFormat::AlignTop);
-
-                cursor.insertImage(icon_fmt);
-                cursor.insertText(" ");
-            }
-
-            QTextCharFormat fmt = standard_link;
-            fmt.setAnchor(true);
-            fmt.setAnchorHref(dst_url);
-            cursor.insertText(title + "\n", fmt);
+            QTextImageFormat icon_fmt;
+            icon_fmt.setFont(this->themed_style.preformatted_font);
+            icon_fmt.setName(QString("gopher/%1").arg(icon));
+            icon_fmt.setVerticalAlignment(QTextImageFormat::AlignTop);
+
+            this->cursor.insertImage(icon_fmt);
+            this->cursor.insertText(" ");
         }
-    }
 
-    return result;
+        QTextCharFormat fmt = this->standard_link;
+        fmt.setAnchor(true);
+        fmt.setAnchorHref(dst_url);
+        this->cursor.insertText(title + "\n", fmt);
+    }
 }
@@ -5,6 +5,8 @@
 
 #include <memory>
 #include <QTextDocument>
+#include <QTextCursor>
+#include <QUrl>
 
 struct GophermapRenderer
 {
@@ -23,4 +25,71 @@ struct GophermapRenderer
     );
 };
 
+//! Renders a gophermap line by line. The parser state is kept between
+//! calls to `append`, so large directory listings can be displayed while
+//! they are still being received. Rendering the input in chunks yields
+//! the same document as `GophermapRenderer::render`.
+class IncrementalGophermapRenderer
+{
+public:
+    //! @param root_url The url that is used to resolve relative links
+    //! @param style    The style which is used to render the document
+    IncrementalGophermapRenderer(
+        QUrl const & root_url,
+        DocumentStyle const & style
+    );
+
+    IncrementalGophermapRenderer(IncrementalGophermapRenderer const &) = delete;
+    IncrementalGophermapRenderer & operator=(IncrementalGophermapRenderer const &) = delete;
+
+    ~IncrementalGophermapRenderer();
+
+    //! Appends the utf8 encoded input to the document. Only complete menu
+    //! lines are rendered, an incomplete last line is kept until more input
+    //! arrives or `finish` is called.
+    void append(QByteArray const & input);
+
+    //! Renders the remaining input.
+    void finish();
+
+    //! The document that is rendered into. Stays valid until `takeDocument`
+    //! is called or the renderer is destroyed.
+    QTextDocument * document() const {
+        return this->result.get();
+    }
+
+    //! Transfers ownership of the document to the caller.
+    //! No further input may be appended after that.
+    std::unique_ptr<QTextDocument> takeDocument();
+
+    //! Total number of bytes passed to `append`.
+    qint64 inputSize() const {
+        return this->input_size;
+    }
+
+private:
+    void renderLine(QByteArray const & line);
+
+private:
+    QUrl root_url;
+    DocumentStyle themed_style;
+
+    std::unique_ptr<QTextDocument> result;
+    QTextCursor cursor;
+
+    QByteArray pending_input;
+    qint64 input_size = 0;
+    bool is_finished = false;
+
+    bool emit_text_only;
+    //! Mirrors are passed to the client instead of being listed
+    bool race_mirrors;
+    //! Target of the last link, which following mirrors belong to
+    QString last_link;
+    QTextCharFormat standard;
+    QTextCharFormat standard_link;
+    QTextCharFormat text_fmt;
+    char last_type = '1';
+};
+
 #endif // GOPHERMAPRENDERER_HPP
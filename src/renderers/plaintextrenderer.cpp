@@ -6,19 +6,66 @@
 #include <QTextCursor>
 #include <QTextDocument>
 #include <memory>
+#include <cassert>
 
 std::unique_ptr<QTextDocument> PlainTextRenderer::render(const QByteArray &input, const DocumentStyle &style)
 {
-    QTextCharFormat standard;
-    standard.setFont(style.preformatted_font);
-    standard.setForeground(style.preformatted_color);
+    IncrementalPlainTextRenderer renderer { style };
+
+    renderer.append(input);
+    renderer.finish();
+
+    return renderer.takeDocument();
+}
+
+IncrementalPlainTextRenderer::IncrementalPlainTextRenderer(const DocumentStyle &style) :
+    result(std::make_unique<QTextDocument>())
+{
+    this->standard.setFont(style.preformatted_font);
+    this->standard.setForeground(style.preformatted_color);
+
+    this->text_fmt = this->standard;
 
-    std::unique_ptr<QTextDocument> result = std::make_unique<QTextDocument>();
     renderhelpers::setPageMargins(result.get(), style.margin_h, style.margin_v);
 
-    QTextCursor cursor { result.get() };
-    QTextCharFormat text_fmt = standard;
-    renderhelpers::renderEscapeCodes(input, text_fmt, standard, cursor);
+    this->cursor = QTextCursor { result.get() };
+}
 
-    return result;
+IncrementalPlainTextRenderer::~IncrementalPlainTextRenderer()
+{
+}
+
+void IncrementalPlainTextRenderer::append(const QByteArray &input)
+{
+    assert(not this->is_finished);
+
+    this->input_size += input.size();
+    this->pending_input.append(input);
+
+    // Only complete lines are rendered, so a <CR> <LF> is never
+    // split and escape sequences don't end up in different chunks.
+    int end = this->pending_input.lastIndexOf('\n');
+    if (end < 0)
+        return;
+
+    renderhelpers::renderEscapeCodes(this->pending_input.left(end + 1), this->text_fmt, this->standard, this->cursor);
+    this->pending_input.remove(0, end + 1);
+}
+
+void IncrementalPlainTextRenderer::finish()
+{
+    if (this->is_finished)
+        return;
+
+    if (not this->pending_input.isEmpty())
+        renderhelpers::renderEscapeCodes(this->pending_input, this->text_fmt, this->standard, this->cursor);
+    this->pending_input.clear();
+    this->is_finished = true;
+}
+
+std::unique_ptr<QTextDocument> IncrementalPlainTextRenderer::takeDocument()
+{
+    this->is_finished = true;
+    this->cursor = QTextCursor { };
+    return std::move(this->result);
 }
@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <QTextDocument>
+#include <QTextCursor>
 
 struct PlainTextRenderer
 {
@@ -22,4 +23,54 @@ struct PlainTextRenderer
     );
 };
 
+//! Renders plain text line by line, so a text file can be displayed
+//! while it is still being received without laying out the whole
+//! text again for each chunk.
+class IncrementalPlainTextRenderer
+{
+public:
+    //! @param style    The style which is used to render the document
+    explicit IncrementalPlainTextRenderer(DocumentStyle const & style);
+
+    IncrementalPlainTextRenderer(IncrementalPlainTextRenderer const &) = delete;
+    IncrementalPlainTextRenderer & operator=(IncrementalPlainTextRenderer const &) = delete;
+
+    ~IncrementalPlainTextRenderer();
+
+    //! Appends the utf8 encoded input to the document. Only complete lines
+    //! are rendered, an incomplete last line is kept until more input
+    //! arrives or `finish` is called.
+    void append(QByteArray const & input);
+
+    //! Renders the remaining input.
+    void finish();
+
+    //! The document that is rendered into. Stays valid until `takeDocument`
+    //! is called or the renderer is destroyed.
+    QTextDocument * document() const {
+        return this->result.get();
+    }
+
+    //! Transfers ownership of the document to the caller.
+    //! No further input may be appended after that.
+    std::unique_ptr<QTextDocument> takeDocument();
+
+    //! Total number of bytes passed to `append`.
+    qint64 inputSize() const {
+        return this->input_size;
+    }
+
+private:
+    std::unique_ptr<QTextDocument> result;
+    QTextCursor cursor;
+
+    QByteArray pending_input;
+    qint64 input_size = 0;
+    bool is_finished = false;
+
+    QTextCharFormat standard;
+    //! Current format, changed by ANSI escape codes
+    QTextCharFormat text_fmt;
+};
+
 #endif // PLAINTEXTRENDERER_HPP
@@ -0,0 +1,78 @@
+#include "requesttimings.hpp"
+
+#include <QObject>
+#include <QStringList>
+
+RequestTimings::RequestTimings()
+{
+    this->events.fill(-1);
+}
+
+void RequestTimings::start()
+{
+    this->events.fill(-1);
+    this->clock.start();
+}
+
+void RequestTimings::record(Event event)
+{
+    if(not this->clock.isValid())
+        return;
+    if(this->events[event] >= 0)
+        return;
+    this->events[event] = this->clock.elapsed();
+}
+
+qint64 RequestTimings::duration(Event event) const
+{
+    if(this->events[event] < 0)
+        return -1;
+    qint64 previous = 0;
+    for(int i = 0; i < event; i++)
+    {
+        if(this->events[i] >= 0)
+            previous = this->events[i];
+    }
+    return this->events[event] - previous;
+}
+
+bool RequestTimings::isValid() const
+{
+    for(qint64 time : this->events)
+    {
+        if(time >= 0)
+            return true;
+    }
+    return false;
+}
+
+QString RequestTimings::toString() const
+{
+    QStringList lines;
+    for(int i = 0; i < event_count; i++)
+    {
+        auto const event = Event(i);
+        if(not this->hasEvent(event))
+            continue;
+        lines << QObject::tr("%1: %2 ms (+%3 ms)")
+            .arg(eventName(event))
+            .arg(this->at(event))
+            .arg(this->duration(event));
+    }
+    return lines.join("\n");
+}
+
+QString RequestTimings::eventName(Event event)
+{
+    switch(event)
+    {
+    case HostFound: return QObject::tr("Host found");
+    case Connected: return QObject::tr("Connected");
+    case TlsEstablished: return QObject::tr("TLS established");
+    case RequestSent: return QObject::tr("Request sent");
+    case FirstByte: return QObject::tr("First byte");
+    case FirstBodyByte: return QObject::tr("First body byte");
+    case Complete: return QObject::tr("Complete");
+    }
+    return QString { };
+}
@@ -0,0 +1,64 @@
+#ifndef REQUESTTIMINGS_HPP
+#define REQUESTTIMINGS_HPP
+
+#include <QString>
+#include <QElapsedTimer>
+
+#include <array>
+
+//! Records when each phase of a single request completed, relative to
+//! the start of the request. Phases a protocol doesn't have (e.g. the
+//! TLS handshake of plain text protocols) stay unset, phases skipped by
+//! reusing a connection complete immediately.
+class RequestTimings
+{
+public:
+    enum Event
+    {
+        HostFound,      //!< The host name was resolved
+        Connected,      //!< The TCP connection was established
+        TlsEstablished, //!< The TLS handshake completed
+        RequestSent,    //!< The request was written to the socket
+        FirstByte,      //!< The first byte of the response was received
+        FirstBodyByte,  //!< The response header was parsed and the body starts
+        Complete,       //!< The last byte of the response was received
+    };
+
+    static constexpr int event_count = Complete + 1;
+
+    RequestTimings();
+
+    //! Starts the clock for a new request and clears all recorded events.
+    void start();
+
+    //! Records that `event` happened now. Only the first occurrence is kept.
+    void record(Event event);
+
+    //! Returns the time of `event` in ms since the start of the request,
+    //! or -1 if it wasn't recorded.
+    qint64 at(Event event) const {
+        return this->events[event];
+    }
+
+    bool hasEvent(Event event) const {
+        return this->events[event] >= 0;
+    }
+
+    //! Returns the time spent between the previous recorded event and `event`
+    //! in ms, or -1 if `event` wasn't recorded.
+    qint64 duration(Event event) const;
+
+    //! True if at least one event was recorded.
+    bool isValid() const;
+
+    //! Formats the recorded phases as one line per event.
+    QString toString() const;
+
+    static QString eventName(Event event);
+
+private:
+    std::array<qint64, event_count> events;
+    QElapsedTimer clock;
+};
+
+#endif // REQUESTTIMINGS_HPP
@@ -0,0 +1,189 @@
+#include "responsebody.hpp"
+#include "kristall.hpp"
+#include "ioutil.hpp"
+
+#include <QDebug>
+#include <QObject>
+#include <algorithm>
+
+ResponseBody::ResponseBody()
+{
+
+}
+
+ResponseBody::~ResponseBody()
+{
+
+}
+
+void ResponseBody::clear()
+{
+    this->memory.clear();
+    this->file.reset();
+    this->total_size = 0;
+    this->is_media = false;
+    this->limit_exceeded = false;
+    this->error_string.clear();
+}
+
+void ResponseBody::reserve(int size)
+{
+    this->memory.reserve(size);
+}
+
+void ResponseBody::setSpillEnabled(bool enabled)
+{
+    this->spill_enabled = enabled;
+}
+
+void ResponseBody::setMimeType(const MimeType &mime)
+{
+    this->is_media = mime.is("image") or mime.is("audio") or mime.is("video");
+}
+
+qint64 ResponseBody::readFrom(QIODevice &device)
+{
+    qint64 const available = device.bytesAvailable();
+    if(available <= 0)
+        return 0;
+
+    if(not checkLimit(available))
+        return -1;
+
+    qint64 len;
+    if(this->file != nullptr)
+    {
+        QByteArray const chunk = device.read(available);
+        len = chunk.size();
+        if(not writeToFile(chunk.constData(), len))
+            return -1;
+    }
+    else
+    {
+        // Read directly behind the already received body
+        int const offset = this->memory.size();
+        this->memory.resize(offset + int(available));
+        len = device.read(this->memory.data() + offset, available);
+        this->memory.resize(offset + int(std::max<qint64>(len, 0)));
+        if(len < 0) {
+            this->error_string = device.errorString();
+            return -1;
+        }
+    }
+
+    this->total_size += len;
+
+    if(not spill())
+        return -1;
+
+    return len;
+}
+
+bool ResponseBody::append(const char *data, qint64 length)
+{
+    if(length <= 0)
+        return true;
+
+    if(not checkLimit(length))
+        return false;
+
+    if(this->file != nullptr) {
+        if(not writeToFile(data, length))
+            return false;
+    } else {
+        this->memory.append(data, int(length));
+    }
+
+    this->total_size += length;
+
+    return spill();
+}
+
+void ResponseBody::truncate(qint64 size)
+{
+    Q_ASSERT(this->file == nullptr);
+    if(size < this->memory.size()) {
+        this->memory.resize(int(size));
+        this->total_size = size;
+    }
+}
+
+QString ResponseBody::takeFile()
+{
+    if(this->file == nullptr)
+        return QString { };
+
+    this->file->flush();
+    this->file->setAutoRemove(false);
+    QString const file_name = this->file->fileName();
+    this->file->close();
+    this->file.reset();
+
+    this->total_size = 0;
+
+    return file_name;
+}
+
+bool ResponseBody::checkLimit(qint64 additional)
+{
+    // Bodies that are only saved are streamed into the file without a limit
+    if(this->file != nullptr or this->willSpill(this->total_size + additional))
+        return true;
+
+    qint64 const limit = qint64(kristall::globals().options.download_limit) * 1024 * 1024;
+    if(limit > 0 and (this->total_size + additional) > limit)
+    {
+        this->limit_exceeded = true;
+        this->error_string = QObject::tr("The document is larger than the download limit of %1.").arg(IoUtil::size_human(limit));
+        return false;
+    }
+    return true;
+}
+
+bool ResponseBody::spill()
+{
+    if(this->file != nullptr or not this->willSpill(this->total_size))
+        return true;
+
+    this->file = std::make_unique<QTemporaryFile>(
+        kristall::globals().dirs.downloads.absoluteFilePath("download-XXXXXX"));
+    if(not this->file->open())
+    {
+        this->error_string = this->file->errorString();
+        this->file.reset();
+        return false;
+    }
+
+    qDebug() << "spilling response body into" << this->file->fileName();
+
+    if(not writeToFile(this->memory.constData(), this->memory.size()))
+        return false;
+
+    // Release the memory, the body now lives in the file
+    this->memory = QByteArray { };
+
+    return true;
+}
+
+bool ResponseBody::willSpill(qint64 size) const
+{
+    if(not this->spill_enabled or this->is_media)
+        return false;
+    qint64 const threshold = qint64(kristall::globals().options.spill_threshold) * 1024 * 1024;
+    return (size > threshold);
+}
+
+bool ResponseBody::writeToFile(const char *data, qint64 length)
+{
+    qint64 offset = 0;
+    while(offset < length)
+    {
+        qint64 const len = this->file->write(data + offset, length - offset);
+        if(len <= 0) {
+            this->error_string = this->file->errorString();
+            return false;
+        }
+        offset += len;
+    }
+    return true;
+}
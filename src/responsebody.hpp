@@ -0,0 +1,91 @@
+#ifndef RESPONSEBODY_HPP
+#define RESPONSEBODY_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QTemporaryFile>
+#include <QString>
+
+#include <memory>
+
+#include "mimeparser.hpp"
+
+//! Receives the body of a response. Small bodies are kept in memory,
+//! bodies larger than the configured spill threshold are moved into
+//! a temporary file in the downloads directory and offered for saving.
+//! Bodies that are displayed and larger than the download limit are rejected.
+class ResponseBody
+{
+public:
+    ResponseBody();
+    ~ResponseBody();
+
+    ResponseBody(ResponseBody const &) = delete;
+    ResponseBody & operator=(ResponseBody const &) = delete;
+
+    //! Drops all received data and removes the temporary file.
+    void clear();
+
+    //! Preallocates memory for bodies up to `size` bytes.
+    void reserve(int size);
+
+    //! Allows or forbids moving the body into a file.
+    //! Protocols that need to scan the body keep it in memory.
+    void setSpillEnabled(bool enabled);
+
+    //! Sets the type of the body. Media is displayed regardless
+    //! of its size, so it is never moved into a file.
+    void setMimeType(MimeType const & mime);
+
+    //! Reads all available data from `device` into the body.
+    //! Returns the number of bytes read or -1 on error.
+    qint64 readFrom(QIODevice & device);
+
+    //! Appends data to the body. Returns false on error.
+    bool append(char const * data, qint64 length);
+
+    //! Shrinks the in-memory body to `size` bytes.
+    void truncate(qint64 size);
+
+    //! Total number of bytes received
+    qint64 size() const { return total_size; }
+
+    bool isEmpty() const { return total_size == 0; }
+
+    //! Returns true if the body was moved into a file.
+    bool isSpilled() const { return file != nullptr; }
+
+    //! Returns true if the last error was caused by the download limit.
+    bool isLimitExceeded() const { return limit_exceeded; }
+
+    //! The in-memory body, empty if the body was spilled into a file.
+    QByteArray const & data() const { return memory; }
+
+    //! Closes the file and passes its ownership to the caller,
+    //! who is responsible for deleting it. The body is empty afterwards.
+    QString takeFile();
+
+    QString errorString() const { return error_string; }
+
+private:
+    //! Checks if `additional` bytes still fit into the download limit.
+    bool checkLimit(qint64 additional);
+
+    //! Returns true if a body of `size` bytes is moved into a file.
+    bool willSpill(qint64 size) const;
+
+    //! Moves the in-memory body into a new temporary file.
+    bool spill();
+
+    bool writeToFile(char const * data, qint64 length);
+
+    QByteArray memory;
+    std::unique_ptr<QTemporaryFile> file;
+    qint64 total_size = 0;
+    bool spill_enabled = true;
+    bool is_media = false;
+    bool limit_exceeded = false;
+    QString error_string;
+};
+
+#endif // RESPONSEBODY_HPP
@@ -0,0 +1,58 @@
+#include "sslconfigcache.hpp"
+#include "kristall.hpp"
+
+QSslConfiguration SslConfigCache::configuration(Profile profile, const QSslCertificate &certificate, const QSslKey &key)
+{
+    auto const & trust = (profile == Gemini) ? kristall::globals().trust.gemini : kristall::globals().trust.https;
+
+    QString entry_key = QString::number(int(profile));
+    if(not certificate.isNull())
+        entry_key += ":" + QString::fromLatin1(certificate.digest(QCryptographicHash::Sha256).toHex());
+
+    auto it = this->entries.find(entry_key);
+    if(it == this->entries.end() or it->enable_ca != trust.enable_ca)
+    {
+        if(it == this->entries.end() and this->entries.size() >= max_entries)
+            this->entries.clear();
+
+        it = this->entries.insert(entry_key, Entry {
+            build(profile, trust.enable_ca, certificate, key),
+            trust.enable_ca,
+        });
+    }
+
+    return it->config;
+}
+
+void SslConfigCache::clear()
+{
+    this->entries.clear();
+}
+
+QSslConfiguration SslConfigCache::build(Profile profile, bool enable_ca, const QSslCertificate &certificate, const QSslKey &key)
+{
+    QSslConfiguration ssl_config = QSslConfiguration::defaultConfiguration();
+    if(profile == Gemini) {
+        ssl_config.setProtocol(QSsl::TlsV1_2OrLater);
+        // Session tickets are stored for resumption by later connections
+        ssl_config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    }
+
+    if(enable_ca)
+        ssl_config.setCaCertificates(systemCaCertificates());
+    else
+        ssl_config.setCaCertificates(QList<QSslCertificate> { });
+
+    if(not certificate.isNull()) {
+        ssl_config.setLocalCertificate(certificate);
+        ssl_config.setPrivateKey(key);
+    }
+
+    return ssl_config;
+}
+
+QList<QSslCertificate> const & SslConfigCache::systemCaCertificates()
+{
+    static QList<QSslCertificate> const certificates = QSslConfiguration::systemCaCertificates();
+    return certificates;
+}
@@ -0,0 +1,51 @@
+#ifndef SSLCONFIGCACHE_HPP
+#define SSLCONFIGCACHE_HPP
+
+#include <QSslConfiguration>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QString>
+#include <QHash>
+#include <QList>
+
+//! Keeps one prepared TLS configuration per trust profile (protocol,
+//! CA setting and client identity), so requests don't have to load
+//! and parse the system CA store each time.
+//! Configurations are rebuilt when the CA setting of the profile changes.
+class SslConfigCache
+{
+public:
+    enum Profile
+    {
+        Gemini,
+        Https,
+    };
+
+    //! Maximum number of cached configurations
+    static constexpr int max_entries = 32;
+
+    //! Returns the configuration for `profile`. If `certificate` is
+    //! not null, the configuration presents it as client certificate.
+    QSslConfiguration configuration(Profile profile, QSslCertificate const & certificate, QSslKey const & key);
+
+    void clear();
+
+    int size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        QSslConfiguration config;
+        //! The CA setting the configuration was built for
+        bool enable_ca;
+    };
+
+    static QSslConfiguration build(Profile profile, bool enable_ca, QSslCertificate const & certificate, QSslKey const & key);
+
+    //! The system CA certificates, loaded on first use
+    static QList<QSslCertificate> const & systemCaCertificates();
+
+    QHash<QString, Entry> entries;
+};
+
+#endif // SSLCONFIGCACHE_HPP
@@ -0,0 +1,125 @@
+#include "sslsessioncache.hpp"
+
+#include <QDebug>
+#include <algorithm>
+
+QByteArray SslSessionCache::find(const QString &host, quint16 port)
+{
+    auto it = this->sessions.find(key(host, port));
+    if(it == this->sessions.end()) {
+        this->miss_count += 1;
+        return QByteArray { };
+    }
+
+    if(QDateTime::currentDateTimeUtc() >= it->expires) {
+        this->sessions.erase(it);
+        this->miss_count += 1;
+        return QByteArray { };
+    }
+
+    this->hit_count += 1;
+    return it->ticket;
+}
+
+void SslSessionCache::store(const QString &host, quint16 port, const QByteArray &ticket, int lifetime_hint)
+{
+    if(ticket.isEmpty())
+        return;
+
+    int lifetime = (lifetime_hint > 0) ? std::min(lifetime_hint, max_lifetime) : default_lifetime;
+
+    if(not this->sessions.contains(key(host, port)) and this->sessions.size() >= max_entries)
+        this->dropOldest();
+
+    auto const now = QDateTime::currentDateTimeUtc();
+    this->sessions.insert(key(host, port), Session {
+        ticket,
+        now.addSecs(lifetime),
+        now,
+    });
+}
+
+void SslSessionCache::remove(const QString &host, quint16 port)
+{
+    this->sessions.remove(key(host, port));
+}
+
+void SslSessionCache::clear()
+{
+    this->sessions.clear();
+}
+
+int SslSessionCache::size() const
+{
+    return this->sessions.size();
+}
+
+void SslSessionCache::load(QSettings &settings)
+{
+    this->sessions.clear();
+
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    int size = settings.beginReadArray("sessions");
+    for(int i = 0; i < size; i++)
+    {
+        settings.setArrayIndex(i);
+
+        Session session {
+            settings.value("ticket").toByteArray(),
+            settings.value("expires").toDateTime(),
+            settings.value("stored", now).toDateTime(),
+        };
+
+        // Drop everything that expired while we were not running
+        if(session.ticket.isEmpty() or not session.expires.isValid() or now >= session.expires)
+            continue;
+
+        if(this->sessions.size() >= max_entries)
+            this->dropOldest();
+
+        this->sessions.insert(settings.value("host").toString(), session);
+    }
+    settings.endArray();
+
+    qDebug() << "tls: loaded" << this->sessions.size() << "session tickets";
+}
+
+void SslSessionCache::save(QSettings &settings) const
+{
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    settings.remove("sessions");
+    settings.beginWriteArray("sessions");
+    int index = 0;
+    for(auto it = this->sessions.begin(); it != this->sessions.end(); ++it)
+    {
+        if(now >= it->expires)
+            continue;
+
+        settings.setArrayIndex(index);
+        settings.setValue("host", it.key());
+        settings.setValue("ticket", it->ticket);
+        settings.setValue("expires", it->expires);
+        settings.setValue("stored", it->stored);
+        index += 1;
+    }
+    settings.endArray();
+}
+
+QString SslSessionCache::key(const QString &host, quint16 port)
+{
+    return QString("%1:%2").arg(host.toLower()).arg(port);
+}
+
+void SslSessionCache::dropOldest()
+{
+    auto oldest = this->sessions.end();
+    for(auto it = this->sessions.begin(); it != this->sessions.end(); ++it)
+    {
+        if(oldest == this->sessions.end() or it->stored < oldest->stored)
+            oldest = it;
+    }
+    if(oldest != this->sessions.end())
+        this->sessions.erase(oldest);
+}
@@ -0,0 +1,67 @@
+#ifndef SSLSESSIONCACHE_HPP
+#define SSLSESSIONCACHE_HPP
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QSettings>
+#include <QHash>
+
+//! Stores TLS session tickets per host, so following connections
+//! to the same host can resume the session instead of doing a
+//! full handshake.
+class SslSessionCache
+{
+public:
+    //! Lifetime of a ticket if the server doesn't provide a hint (in seconds)
+    static constexpr int default_lifetime = 60 * 60;
+
+    //! Upper bound for the lifetime of a ticket (in seconds)
+    static constexpr int max_lifetime = 24 * 60 * 60;
+
+    //! Maximum number of stored session tickets
+    static constexpr int max_entries = 256;
+
+    //! Returns the session ticket for the given host or an empty array
+    //! if none is known or the ticket has expired.
+    QByteArray find(QString const & host, quint16 port);
+
+    //! Stores the session ticket for the given host.
+    //! @param lifetime_hint The lifetime announced by the server in seconds, or a value <= 0 if unknown.
+    void store(QString const & host, quint16 port, QByteArray const & ticket, int lifetime_hint);
+
+    //! Removes the ticket for the given host, e.g. when the
+    //! server rejected the resumed session.
+    void remove(QString const & host, quint16 port);
+
+    void clear();
+
+    int size() const;
+
+    //! Number of lookups that returned a ticket, i.e. handshakes that
+    //! attempted to resume a session.
+    int hits() const { return hit_count; }
+    int misses() const { return miss_count; }
+
+    void load(QSettings & settings);
+    void save(QSettings & settings) const;
+
+private:
+    struct Session
+    {
+        QByteArray ticket;
+        QDateTime expires;
+        QDateTime stored;
+    };
+
+    static QString key(QString const & host, quint16 port);
+
+    //! Removes the ticket that was stored first
+    void dropOldest();
+
+    QHash<QString, Session> sessions;
+    int hit_count = 0;
+    int miss_count = 0;
+};
+
+#endif // SSLSESSIONCACHE_HPP
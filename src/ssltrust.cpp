@@ -81,6 +81,26 @@ SslTrust::TrustStatus SslTrust::getTrust(const QUrl &url, const QSslCertificate
     if(trust_level == TrustEverything)
         return Trusted;
 
+    // Comparing public keys encodes both of them, which is costly
+    // compared to looking up the result for a known fingerprint.
+    QString const key = url.host() + "\n" + QString::fromLatin1(certificate.digest(QCryptographicHash::Sha256).toHex());
+    if(auto it = verifications.find(key); it != verifications.end())
+    {
+        if(it->trust_level == trust_level and it->revision == trusted_hosts.revision())
+            return it->status;
+    }
+
+    TrustStatus const status = verify(url, certificate);
+
+    if(verifications.size() >= max_verifications)
+        verifications.clear();
+    verifications.insert(key, Verification { status, trust_level, trusted_hosts.revision() });
+
+    return status;
+}
+
+SslTrust::TrustStatus SslTrust::verify(const QUrl &url, const QSslCertificate &certificate)
+{
     if(auto host_or_none = trusted_hosts.get(url.host()); host_or_none)
     {
         if(host_or_none->public_key == certificate.publicKey())
@@ -105,6 +125,16 @@ SslTrust::TrustStatus SslTrust::getTrust(const QUrl &url, const QSslCertificate
     }
 }
 
+bool SslTrust::isMistrusted(const QUrl &url, const QSslCertificate &certificate) const
+{
+    if(trust_level == TrustEverything)
+        return false;
+
+    if(auto host_or_none = trusted_hosts.get(url.host()); host_or_none)
+        return (host_or_none->public_key != certificate.publicKey());
+    return false;
+}
+
 bool SslTrust::isTrustRelated(QSslError::SslError err)
 {
     switch(err)
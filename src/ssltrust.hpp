@@ -5,6 +5,7 @@
 #include <QSslKey>
 #include <QSettings>
 #include <QSslError>
+#include <QHash>
 
 #include "trustedhostcollection.hpp"
 
@@ -45,7 +46,29 @@ struct SslTrust
 
     TrustStatus getTrust(QUrl const & url, QSslCertificate const & certificate);
 
+    //! Returns `true` if another key is pinned for the host. Unlike `getTrust`,
+    //! this never adds the host to the trust store.
+    bool isMistrusted(QUrl const & url, QSslCertificate const & certificate) const;
+
     static bool isTrustRelated(QSslError::SslError err);
+
+private:
+    //! Maximum number of memoized results of `getTrust`
+    static constexpr int max_verifications = 256;
+
+    //! Checks the certificate against the trust store without memoization.
+    TrustStatus verify(QUrl const & url, QSslCertificate const & certificate);
+
+    struct Verification
+    {
+        TrustStatus status;
+        TrustLevel trust_level;
+        //! Revision of `trusted_hosts` the result was computed for
+        quint64 revision;
+    };
+
+    //! Results of `getTrust` by host and certificate fingerprint
+    QHash<QString, Verification> verifications;
 };
 
 #endif // SSLTRUST_HPP
@@ -1,21 +1,34 @@
 #include "trustedhostcollection.hpp"
 
 #include <cassert>
+#include <atomic>
+
+//! Revisions are unique across all collections, so two collections with
+//! the same revision always contain the same hosts, even after one was
+//! assigned to the other.
+static quint64 nextRevision()
+{
+    static std::atomic<quint64> last_revision { 0 };
+    return ++last_revision;
+}
 
 TrustedHostCollection::TrustedHostCollection(QObject *parent)
-    : QAbstractTableModel(parent)
+    : QAbstractTableModel(parent),
+      current_revision(nextRevision())
 {
 }
 
 TrustedHostCollection::TrustedHostCollection(const TrustedHostCollection & other) :
-    items(other.items)
+    items(other.items),
+    current_revision(other.current_revision)
 {
     assert(other.parent() == nullptr);
 
 }
 
 TrustedHostCollection::TrustedHostCollection(TrustedHostCollection &&other) :
-    items(std::move(other.items))
+    items(std::move(other.items)),
+    current_revision(other.current_revision)
 {
     assert(other.parent() == nullptr);
 }
@@ -83,6 +96,7 @@ TrustedHostCollection &TrustedHostCollection::operator=(const TrustedHostCollect
 {
     beginResetModel();
     this->items = other.items;
+    this->current_revision = other.current_revision;
     endResetModel();
     return *this;
 }
@@ -91,6 +105,7 @@ TrustedHostCollection &TrustedHostCollection::operator=(TrustedHostCollection &&
 {
     beginResetModel();
     this->items = std::move(other.items);
+    this->current_revision = other.current_revision;
     endResetModel();
     return *this;
 }
@@ -99,6 +114,7 @@ void TrustedHostCollection::clear()
 {
     beginResetModel();
     this->items.clear();
+    this->current_revision = nextRevision();
     endResetModel();
 }
 
@@ -112,6 +128,7 @@ bool TrustedHostCollection::insert(const TrustedHost &host)
 
     beginInsertRows(QModelIndex { }, items.size(), items.size() + 1);
     items.append(host);
+    current_revision = nextRevision();
     endInsertRows();
 
     return true;
@@ -144,6 +161,7 @@ void TrustedHostCollection::remove(const QModelIndex &index)
         return;
     beginRemoveRows(QModelIndex{}, index.row(), index.row());
     items.removeAt(index.row());
+    current_revision = nextRevision();
     endRemoveRows();
 }
 
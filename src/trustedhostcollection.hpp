@@ -41,8 +41,14 @@ public:
 
     QVector<TrustedHost> getAll() const;
 
+    //! Changes whenever a host is added or removed, so results
+    //! derived from the collection can be invalidated. Revisions are
+    //! never reused, not even by other collections.
+    quint64 revision() const { return current_revision; }
+
 private:
     QVector<TrustedHost> items;
+    quint64 current_revision;
 };
 
 #endif // TRUSTEDHOSTCOLLECTION_HPP
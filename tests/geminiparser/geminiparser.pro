@@ -0,0 +1,17 @@
+# Benchmark for GeminiResponseParser with fragmented response headers
+
+QT = core
+
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+
+TARGET = geminiparser-benchmark
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    ../../src/protocols/geminiresponseparser.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../src/protocols/geminiresponseparser.hpp
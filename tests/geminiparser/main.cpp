@@ -0,0 +1,157 @@
+#include "protocols/geminiresponseparser.hpp"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    struct Response
+    {
+        char const * name;
+        QByteArray data;
+        int primary_code;
+        int secondary_code;
+        QByteArray meta;
+        qint64 header_length;
+    };
+
+    //! Sizes of the fragments a response is fed to the parser in
+    using Chunks = QVector<qint64>;
+
+    Response makeResponse(char const * name, int primary, int secondary, QByteArray const & meta)
+    {
+        Response response;
+        response.name = name;
+        response.primary_code = primary;
+        response.secondary_code = secondary;
+        response.meta = meta;
+        response.data = QByteArray::number(10 * primary + secondary) + " " + meta + "\r\n";
+        response.header_length = response.data.size();
+        response.data += "# Body\r\nThe body must never be consumed by the parser.\r\n";
+        return response;
+    }
+
+    //! Feeds `response` to `parser` split into `chunks`, the last chunk is
+    //! repeated until the data is exhausted. Returns the offset of the body
+    //! or -1 if no valid header was found.
+    qint64 feed(GeminiResponseParser & parser, QByteArray const & response, Chunks const & chunks)
+    {
+        parser.reset();
+
+        qint64 offset = 0;
+        int index = 0;
+        while(offset < response.size())
+        {
+            qint64 const length = std::min(chunks.at(index), response.size() - offset);
+            index = std::min(index + 1, chunks.size() - 1);
+
+            qint64 consumed = 0;
+            switch(parser.feed(response.constData() + offset, length, consumed))
+            {
+            case GeminiResponseParser::NeedMoreData:
+                if(consumed != length)
+                    return -1;
+                offset += consumed;
+                break;
+            case GeminiResponseParser::HeaderComplete:
+                return offset + consumed;
+            case GeminiResponseParser::Error:
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+    bool verify(GeminiResponseParser const & parser, Response const & response, qint64 body_offset)
+    {
+        return (body_offset == response.header_length)
+            and (parser.primaryCode() == response.primary_code)
+            and (parser.secondaryCode() == response.secondary_code)
+            and (parser.meta() == response.meta);
+    }
+
+    //! All ways of splitting the header of `response` into two fragments
+    QVector<Chunks> splitHeader(Response const & response)
+    {
+        QVector<Chunks> result;
+        for(qint64 split = 1; split < response.header_length; split++)
+            result.append(Chunks { split, response.data.size() });
+        return result;
+    }
+
+    //! Splits between <CR> and <LF>, right before <CR> and right after <LF>
+    QVector<Chunks> splitLineEnd(Response const & response)
+    {
+        qint64 const cr = response.header_length - 2;
+        return QVector<Chunks> {
+            Chunks { cr + 1, response.data.size() },
+            Chunks { cr, 1, response.data.size() },
+            Chunks { cr, 2, response.data.size() },
+            Chunks { 1, 1, 1, cr - 2, 1, response.data.size() },
+        };
+    }
+
+    //! Parses `response` once for each split in `splits` per iteration and
+    //! prints the header throughput. Returns false if any parse went wrong.
+    bool run(char const * scenario, Response const & response, QVector<Chunks> const & splits, int iterations)
+    {
+        GeminiResponseParser parser;
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < iterations; i++)
+        {
+            for(Chunks const & chunks : splits)
+            {
+                qint64 const body_offset = feed(parser, response.data, chunks);
+                if(not verify(parser, response, body_offset)) {
+                    std::fprintf(stderr, "%s/%s: wrong result for chunks starting with %lld bytes: %s\n",
+                        response.name,
+                        scenario,
+                        static_cast<long long>(chunks.first()),
+                        qPrintable(parser.errorString()));
+                    return false;
+                }
+            }
+        }
+        qint64 const elapsed = std::max<qint64>(timer.nsecsElapsed(), 1);
+
+        double const headers = double(iterations) * splits.size();
+        double const seconds = elapsed / 1e9;
+        std::printf("%-12s %-16s %10.1f MB/s %12.0f headers/s\n",
+            response.name,
+            scenario,
+            headers * response.header_length / seconds / 1e6,
+            headers / seconds);
+        return true;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    int iterations = 20000;
+    if(argc > 1)
+        iterations = std::max(1, std::atoi(argv[1]));
+
+    QVector<Response> const responses {
+        makeResponse("success", 2, 0, "text/gemini; charset=utf-8; lang=en"),
+        makeResponse("redirect", 3, 1, "gemini://example.com/" + QByteArray(1000, 'x')),
+        makeResponse("lone-cr", 4, 4, "slow\rdown"),
+    };
+
+    bool ok = true;
+    for(Response const & response : responses)
+    {
+        ok &= run("single chunk", response, { Chunks { response.data.size() } }, iterations);
+        ok &= run("byte by byte", response, { Chunks { 1 } }, std::max(1, iterations / 10));
+        ok &= run("split header", response, splitHeader(response), std::max(1, iterations / 100));
+        ok &= run("split CR LF", response, splitLineEnd(response), iterations);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,94 @@
+# Checks that rendering gemtext in chunks yields the same document
+# and outline as rendering it in one go.
+
+QT += core gui widgets network
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = geminirenderer-check
+
+!win32: LIBS += -lcrypto
+
+INCLUDEPATH += ../../src
+
+# The renderer needs kristall::globals(), which pulls in all non-UI parts
+SOURCES += \
+    ../../src/cachehandler.cpp \
+    ../../src/certificatehelper.cpp \
+    ../../src/connectionpool.cpp \
+    ../../src/cryptoidentity.cpp \
+    ../../src/documentoutlinemodel.cpp \
+    ../../src/documentstyle.cpp \
+    ../../src/favouritecollection.cpp \
+    ../../src/gophermirrors.cpp \
+    ../../src/hostconnector.cpp \
+    ../../src/hostresolver.cpp \
+    ../../src/hosttimings.cpp \
+    ../../src/identitycollection.cpp \
+    ../../src/ioutil.cpp \
+    ../../src/mimeparser.cpp \
+    ../../src/networkservice.cpp \
+    ../../src/networkstatistics.cpp \
+    ../../src/protocolhandler.cpp \
+    ../../src/protocols/abouthandler.cpp \
+    ../../src/protocols/filehandler.cpp \
+    ../../src/protocols/fingerclient.cpp \
+    ../../src/protocols/geminiclient.cpp \
+    ../../src/protocols/geminiresponseparser.cpp \
+    ../../src/protocols/gopherclient.cpp \
+    ../../src/protocols/offlinehandler.cpp \
+    ../../src/protocols/webclient.cpp \
+    ../../src/protocolsetup.cpp \
+    ../../src/redirectcache.cpp \
+    ../../src/renderers/geminirenderer.cpp \
+    ../../src/renderers/renderhelpers.cpp \
+    ../../src/renderers/textstyleinstance.cpp \
+    ../../src/requesttimings.cpp \
+    ../../src/responsebody.cpp \
+    ../../src/sslconfigcache.cpp \
+    ../../src/sslsessioncache.cpp \
+    ../../src/ssltrust.cpp \
+    ../../src/trustedhost.cpp \
+    ../../src/trustedhostcollection.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../src/cachehandler.hpp \
+    ../../src/certificatehelper.hpp \
+    ../../src/connectionpool.hpp \
+    ../../src/cryptoidentity.hpp \
+    ../../src/documentoutlinemodel.hpp \
+    ../../src/documentstyle.hpp \
+    ../../src/favouritecollection.hpp \
+    ../../src/gophermirrors.hpp \
+    ../../src/hostconnector.hpp \
+    ../../src/hostresolver.hpp \
+    ../../src/hosttimings.hpp \
+    ../../src/identitycollection.hpp \
+    ../../src/ioutil.hpp \
+    ../../src/kristall.hpp \
+    ../../src/mimeparser.hpp \
+    ../../src/networkservice.hpp \
+    ../../src/networkstatistics.hpp \
+    ../../src/protocolhandler.hpp \
+    ../../src/protocols/abouthandler.hpp \
+    ../../src/protocols/filehandler.hpp \
+    ../../src/protocols/fingerclient.hpp \
+    ../../src/protocols/geminiclient.hpp \
+    ../../src/protocols/geminiresponseparser.hpp \
+    ../../src/protocols/gopherclient.hpp \
+    ../../src/protocols/offlinehandler.hpp \
+    ../../src/protocols/webclient.hpp \
+    ../../src/protocolsetup.hpp \
+    ../../src/redirectcache.hpp \
+    ../../src/renderers/geminirenderer.hpp \
+    ../../src/renderers/renderhelpers.hpp \
+    ../../src/renderers/textstyleinstance.hpp \
+    ../../src/requesttimings.hpp \
+    ../../src/responsebody.hpp \
+    ../../src/sslconfigcache.hpp \
+    ../../src/sslsessioncache.hpp \
+    ../../src/ssltrust.hpp \
+    ../../src/trustedhost.hpp \
+    ../../src/trustedhostcollection.hpp
@@ -0,0 +1,197 @@
+#include "kristall.hpp"
+#include "renderers/geminirenderer.hpp"
+
+#include <QApplication>
+#include <QCryptographicHash>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+static std::unique_ptr<kristall::Globals> check_globals;
+
+kristall::Globals & kristall::globals()
+{
+    return *check_globals;
+}
+
+const bool kristall::EMOJIS_SUPPORTED = false;
+
+QString toFingerprintString(QSslCertificate const & certificate)
+{
+    return QCryptographicHash::hash(certificate.toDer(), QCryptographicHash::Sha256).toHex(':');
+}
+
+namespace
+{
+    //! A named position in the test document at which the input is split
+    struct Boundary
+    {
+        char const * name;
+        char const * marker;
+        int offset;
+    };
+
+    char const * const test_document =
+        "# Chunked rendering\n"
+        "Some *bold* and _underlined_ text with \"quotes\".\n"
+        "## A list\n"
+        "* first item\n"
+        "* second item with *bold* text\n"
+        "* third item\n"
+        "Paragraph after the list.\n"
+        "> quoted line one\n"
+        "> quoted line two\n"
+        "> quoted line three\n"
+        "Paragraph after the quote.\n"
+        "```preformatted\n"
+        "  indented *code*\n"
+        "second code line\n"
+        "```\n"
+        "### Links\n"
+        "=> gemini://example.com/ Other host\n"
+        "=> page.gmi Same host\n"
+        "=> https://example.com/ Other scheme\n"
+        "\n"
+        "The last line has no trailing newline";
+
+    //! Boundaries the renderer has to carry state across
+    QVector<Boundary> const boundaries {
+        { "inside a preformatted block", "second code line", 6 },
+        { "between preformatted lines", "second code line", 0 },
+        { "inside a list run", "* second item", 4 },
+        { "between list items", "* third item", 0 },
+        { "inside a blockquote", "> quoted line two", 9 },
+        { "between blockquote lines", "> quoted line three", 0 },
+        { "inside the last line", "The last line", 8 },
+    };
+
+    QString flattenOutline(DocumentOutlineModel const & outline, QModelIndex const & parent = QModelIndex { }, int depth = 0)
+    {
+        QString result;
+        for(int row = 0; row < outline.rowCount(parent); row++)
+        {
+            auto const index = outline.index(row, 0, parent);
+            result += QString("%1%2 #%3\n")
+                .arg(QString(2 * depth, ' '))
+                .arg(outline.getTitle(index))
+                .arg(outline.getAnchor(index));
+            result += flattenOutline(outline, index, depth + 1);
+        }
+        return result;
+    }
+
+    struct Rendering
+    {
+        QString html;
+        QString outline;
+        QString title;
+
+        bool operator==(Rendering const & other) const {
+            return (this->html == other.html)
+                and (this->outline == other.outline)
+                and (this->title == other.title);
+        }
+    };
+
+    Rendering renderOneShot(QByteArray const & input, QUrl const & url)
+    {
+        DocumentOutlineModel outline;
+        QString title;
+        auto document = GeminiRenderer::render(input, url, kristall::globals().document_style.derive(url), outline, title);
+        return Rendering { document->toHtml(), flattenOutline(outline), title };
+    }
+
+    //! Renders `input` split at each of `offsets`, which must be ascending.
+    Rendering renderChunked(QByteArray const & input, QUrl const & url, QVector<int> const & offsets)
+    {
+        DocumentOutlineModel outline;
+        IncrementalGeminiRenderer renderer { url, kristall::globals().document_style.derive(url), outline };
+
+        int start = 0;
+        for(int offset : offsets)
+        {
+            renderer.append(input.mid(start, offset - start));
+            start = offset;
+        }
+        renderer.append(input.mid(start));
+        renderer.finish();
+
+        auto document = renderer.takeDocument();
+        return Rendering { document->toHtml(), flattenOutline(outline), renderer.pageTitle() };
+    }
+
+    bool check(char const * variant, char const * name, Rendering const & expected, Rendering const & actual)
+    {
+        if(actual == expected)
+            return true;
+        std::fprintf(stderr, "%s: chunked rendering split %s differs from one-shot rendering%s%s%s\n",
+            variant,
+            name,
+            (actual.html != expected.html) ? ", document differs" : "",
+            (actual.outline != expected.outline) ? ", outline differs" : "",
+            (actual.title != expected.title) ? ", title differs" : "");
+        return false;
+    }
+
+    bool checkDocument(char const * variant, QByteArray const & input)
+    {
+        QUrl const url { "gemini://kristall.test/check.gmi" };
+
+        Rendering const expected = renderOneShot(input, url);
+
+        bool ok = true;
+
+        QVector<int> all_boundaries;
+        for(auto const & boundary : boundaries)
+        {
+            int const marker = input.indexOf(boundary.marker);
+            if(marker < 0) {
+                std::fprintf(stderr, "%s: marker for %s not found\n", variant, boundary.name);
+                return false;
+            }
+            int const offset = marker + boundary.offset;
+            all_boundaries.append(offset);
+            ok &= check(variant, boundary.name, expected, renderChunked(input, url, { offset }));
+        }
+        std::sort(all_boundaries.begin(), all_boundaries.end());
+        ok &= check(variant, "at all boundaries", expected, renderChunked(input, url, all_boundaries));
+
+        for(int offset = 1; offset < input.size(); offset++)
+        {
+            auto const name = QString("at offset %1").arg(offset).toUtf8();
+            ok &= check(variant, name.constData(), expected, renderChunked(input, url, { offset }));
+        }
+
+        QVector<int> every_byte;
+        for(int offset = 1; offset < input.size(); offset++)
+            every_byte.append(offset);
+        ok &= check(variant, "byte by byte", expected, renderChunked(input, url, every_byte));
+
+        std::printf("%s: %s\n", variant, ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    QApplication app(argc, argv);
+
+    check_globals = std::make_unique<kristall::Globals>();
+    kristall::globals().options.enable_text_decoration = true;
+
+    QByteArray const document(test_document);
+    QByteArray crlf_document = document;
+    crlf_document.replace("\n", "\r\n");
+
+    bool ok = true;
+    ok &= checkDocument("LF", document);
+    ok &= checkDocument("CRLF", crlf_document);
+
+    check_globals.reset();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,8 @@
+# Standalone checks and benchmarks for parts of kristall that don't need
+# a running browser. Build with `make check` in the repository root.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    geminiparser \
+    geminirenderer